@@ -8,7 +8,8 @@ public class Khopesh : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "OnlineSubsystem", "OnlineSubsystemUtils" });
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "OnlineSubsystem", "OnlineSubsystemUtils", "ReplicationGraph", "KhopeshRules" });
+        PrivateDependencyModuleNames.Add("AssetRegistry");
         DynamicallyLoadedModuleNames.Add("OnlineSubsystemNull");
     }
 }
@@ -4,4 +4,7 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Khopesh, "Khopesh" );
+
+DEFINE_LOG_CATEGORY(LogKhopesh);
+CSV_DEFINE_CATEGORY(Khopesh, true);
  
\ No newline at end of file
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshAllocCommandlet.h"
+#include "Khopesh.h"
+#include "KhopeshRollback.h"
+#include "KhopeshCountingMalloc.h"
+
+namespace
+{
+	struct FScriptStep
+	{
+		uint8 Buttons;
+		int32 Frames;
+	};
+
+	// Three hit combo, defense, short dodge and long dodge, with pauses for the windows to close
+	FScriptStep const Script[] =
+	{
+		{ EDuelButton::ATTACK, 1 }, { 0, 14 },
+		{ EDuelButton::ATTACK, 1 }, { 0, 14 },
+		{ EDuelButton::ATTACK, 1 }, { 0, 40 },
+		{ EDuelButton::DEFENSE, 1 }, { 0, 40 },
+		{ EDuelButton::DODGE, 4 }, { 0, 70 },
+		{ EDuelButton::DODGE, 40 }, { 0, 70 },
+	};
+
+	class FScriptPlayer
+	{
+	public:
+		explicit FScriptPlayer(int32 InStep) : Step(InStep % ARRAY_COUNT(Script)), StepFrame(0) {}
+
+		FKhopeshDuelInput Next(float Yaw)
+		{
+			FKhopeshDuelInput Input;
+			Input.Buttons = Script[Step].Buttons;
+			Input.Yaw = FKhopeshYaw(Yaw);
+
+			if (++StepFrame >= Script[Step].Frames)
+			{
+				Step = (Step + 1) % ARRAY_COUNT(Script);
+				StepFrame = 0;
+			}
+
+			return Input;
+		}
+
+	private:
+		int32 Step;
+		int32 StepFrame;
+	};
+}
+
+UKhopeshAllocCommandlet::UKhopeshAllocCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UKhopeshAllocCommandlet::Main(FString const& Params)
+{
+	int32 Frames = 18000;
+	int32 Warmup = 600;
+	int32 Latency = 4;
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+	FParse::Value(*Params, TEXT("Warmup="), Warmup);
+	FParse::Value(*Params, TEXT("Latency="), Latency);
+
+	Frames = FMath::Max(Frames, 1);
+	Warmup = FMath::Max(Warmup, 0);
+	Latency = FMath::Clamp(Latency, 0, FKhopeshRollbackSession::MaxRollbackFrames - 1);
+
+	// Close enough that every attack reaches
+	FKhopeshDuel Duel;
+	Duel.Locations[0] = FVector(0.0f, 0.0f, 0.0f);
+	Duel.Locations[1] = FVector(120.0f, 0.0f, 0.0f);
+	Duel.Yaws[0] = FKhopeshYaw(0.0f);
+	Duel.Yaws[1] = FKhopeshYaw(180.0f);
+	Duel.HP = 100.0f;
+
+	FKhopeshDuelRules const Rules;
+	FKhopeshDuelSnapshot const Start = FKhopeshRollbackSession::MakeStart(Duel);
+
+	// A finished duel restarts by copy, the same sizes never reallocate
+	FKhopeshRollbackSession const FreshClient(Rules, Start, 0);
+	FKhopeshRollbackSession const FreshServer(Rules, Start, INDEX_NONE);
+	FKhopeshRollbackSession Client = FreshClient;
+	FKhopeshRollbackSession Server = FreshServer;
+
+	// The second fighter is half a script behind, so that its defenses meet the first one's combos
+	FScriptPlayer LocalPlayer(0);
+	FScriptPlayer RemotePlayer(ARRAY_COUNT(Script) / 2);
+	int32 RemoteFrame = FKhopeshRollbackSession::InputDelay;
+
+	FKhopeshDuelInputs Inputs;
+	int32 Duels = 1;
+	int32 Rollbacks = 0;
+
+	static FKhopeshCountingMalloc CountingMalloc;
+
+	for (int32 Frame = 0; Frame < Warmup + Frames; ++Frame)
+	{
+		if (Frame == Warmup)
+		{
+			CountingMalloc.Reset();
+			CountingMalloc.Begin();
+		}
+
+		FKhopeshDuelSnapshot const& State = Server.GetState();
+		if (State.Fighters[0].HP <= 0.0f || State.Fighters[1].HP <= 0.0f)
+		{
+			Client = FreshClient;
+			Server = FreshServer;
+			RemoteFrame = FKhopeshRollbackSession::InputDelay;
+			++Duels;
+		}
+
+		// The remote fighter is Latency frames behind, so its changes correct the client's predictions
+		while (RemoteFrame <= Client.GetFrame() + FKhopeshRollbackSession::InputDelay - Latency)
+		{
+			FKhopeshDuelInput const RemoteInput = RemotePlayer.Next(Server.GetState().Fighters[1].Yaw);
+			Client.AddRemoteInput(1, RemoteFrame, RemoteInput);
+			Server.AddRemoteInput(1, RemoteFrame, RemoteInput);
+			++RemoteFrame;
+		}
+
+		if (Client.CanAdvance())
+		{
+			Client.AddLocalInput(LocalPlayer.Next(Client.GetState().Fighters[0].Yaw));
+			Client.Advance();
+			Rollbacks += Client.GetLastRollbackFrames() > 0;
+
+			// What the client sends, as the server receives it
+			Client.GetLocalInputs(Inputs);
+			Server.AddRemoteInputs(0, Inputs);
+		}
+
+		while (Server.CanAdvance())
+		{
+			Server.Advance();
+		}
+	}
+
+	CountingMalloc.End();
+
+	UE_LOG(LogKhopesh, Display, TEXT("Played %d frames after %d warmup frames, %d duels, %d rollbacks"), Frames, Warmup, Duels, Rollbacks);
+
+	if (CountingMalloc.GetAllocs() > 0)
+	{
+		UE_LOG(LogKhopesh, Error, TEXT("Combat allocated %d times, %llu bytes, during the measured frames"),
+			CountingMalloc.GetAllocs(), CountingMalloc.GetBytes());
+		return 1;
+	}
+
+	UE_LOG(LogKhopesh, Display, TEXT("No allocation during the measured frames"));
+	return 0;
+}
\ No newline at end of file
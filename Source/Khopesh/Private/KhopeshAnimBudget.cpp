@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshAnimBudget.h"
+#include "Khopesh.h"
+#include "KhopeshCharacter.h"
+#include "KhopeshAnimInstance.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+DECLARE_CYCLE_STAT(TEXT("Anim Budget"), STAT_KhopeshAnimBudget, STATGROUP_Khopesh);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Anim Work Ms"), STAT_KhopeshAnimWorkMs, STATGROUP_Khopesh);
+
+static TAutoConsoleVariable<float> CVarAnimBudgetMs(
+	TEXT("khopesh.AnimBudgetMs"), 2.0f,
+	TEXT("Animation update and evaluation time allowed per frame, in milliseconds. 0 updates every character every frame."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarAnimRateDistance(
+	TEXT("khopesh.AnimRateDistance"), 2500.0f,
+	TEXT("Distance from the camera past which a character updates one frame less often, per step."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarAnimMaxRate(
+	TEXT("khopesh.AnimMaxRate"), 8,
+	TEXT("Most frames between two updates of a character, also used for characters not rendered."),
+	ECVF_Scalability);
+
+static FThreadSafeCounter64 WorkCycles;
+static FThreadSafeCounter64 WorkUpdates;
+
+FKhopeshAnimBudget::FKhopeshAnimBudget()
+{
+	UpdateCostMs = 0.05f;
+	FrameTime = 1.0f / 60.0f;
+}
+
+void FKhopeshAnimBudget::AddWork(uint64 Cycles, int32 Updates)
+{
+	WorkCycles.Add(static_cast<int64>(Cycles));
+	WorkUpdates.Add(Updates);
+}
+
+void FKhopeshAnimBudget::Tick(APlayerController* Controller, float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshAnimBudget);
+
+	float const WorkMs = static_cast<float>(FPlatformTime::ToMilliseconds64(WorkCycles.Set(0)));
+	int64 const Updates = WorkUpdates.Set(0);
+	SET_FLOAT_STAT(STAT_KhopeshAnimWorkMs, WorkMs);
+
+	if (Updates > 0)
+	{
+		UpdateCostMs = FMath::Lerp(UpdateCostMs, WorkMs / Updates, 0.1f);
+	}
+
+	FrameTime = FMath::Lerp(FrameTime, DeltaSeconds, 0.1f);
+
+	for (auto It = AppliedRates.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	struct FCandidate
+	{
+		USkeletalMeshComponent* Mesh;
+		float Distance;
+		int32 MinRate;
+	};
+
+	TArray<FCandidate, TInlineAllocator<32>> Candidates;
+
+	float const BudgetMs = CVarAnimBudgetMs.GetValueOnGameThread();
+	float const RateDistance = FMath::Max(CVarAnimRateDistance.GetValueOnGameThread(), 1.0f);
+	int32 const MaxRate = FMath::Max(CVarAnimMaxRate.GetValueOnGameThread(), 1);
+	FVector const ViewLocation = Controller->PlayerCameraManager
+		? Controller->PlayerCameraManager->GetCameraLocation() : Controller->GetFocalLocation();
+
+	// Characters that always update are paid first
+	float RemainingUpdates = (BudgetMs > 0.0f) ? BudgetMs / FMath::Max(UpdateCostMs, KINDA_SMALL_NUMBER) : MAX_flt;
+
+	for (TActorIterator<AKhopeshCharacter> It(Controller->GetWorld()); It; ++It)
+	{
+		AKhopeshCharacter* Character = *It;
+		USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+		if (Character->HasAuthority() || Character->IsLocallyControlled() || BudgetMs <= 0.0f)
+		{
+			ApplyRate(Mesh, 1);
+			RemainingUpdates -= 1.0f;
+			continue;
+		}
+
+		// The pose of a finished death montage never changes
+		auto Anim = Cast<UKhopeshAnimInstance>(Mesh->GetAnimInstance());
+		bool const IsFinished = Character->GetHP() <= 0.0f && Anim && !Anim->IsMontagePlay(EMontage::DIE);
+		if (Mesh->IsComponentTickEnabled() == IsFinished)
+		{
+			Mesh->SetComponentTickEnabled(!IsFinished);
+		}
+
+		if (IsFinished) continue;
+
+		float const Distance = FVector::Dist(ViewLocation, Character->GetActorLocation());
+		int32 const MinRate = Mesh->WasRecentlyRendered(0.2f) ? 1 + FMath::FloorToInt(Distance / RateDistance) : MaxRate;
+		Candidates.Add({ Mesh, Distance, FMath::Min(MinRate, MaxRate) });
+	}
+
+	Candidates.Sort([](FCandidate const& A, FCandidate const& B)
+	{
+		return A.MinRate != B.MinRate ? A.MinRate < B.MinRate : A.Distance < B.Distance;
+	});
+
+	// Each character gets the rate its distance asks for, or a lower one when the rest no longer fits the budget
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+	{
+		int32 const Remaining = Candidates.Num() - Index;
+		int32 Rate = Candidates[Index].MinRate;
+
+		if (RemainingUpdates < Remaining / static_cast<float>(Rate))
+		{
+			Rate = (RemainingUpdates > 0.0f) ? FMath::CeilToInt(Remaining / RemainingUpdates) : MaxRate;
+			Rate = FMath::Clamp(Rate, Candidates[Index].MinRate, MaxRate);
+		}
+
+		RemainingUpdates -= 1.0f / Rate;
+		ApplyRate(Candidates[Index].Mesh, Rate);
+	}
+}
+
+void FKhopeshAnimBudget::ApplyRate(USkeletalMeshComponent* Mesh, int32 Rate)
+{
+	// Half a frame short of the rate, so that frame time jitter does not skip one more
+	float const Interval = (Rate > 1) ? (Rate - 0.5f) * FrameTime : 0.0f;
+
+	FAppliedRate* Applied = AppliedRates.Find(Mesh);
+	if (Applied && Applied->Rate == Rate && FMath::Abs(Applied->Interval - Interval) < 0.5f * FrameTime) return;
+
+	// Every change moves the tick function between the tick lists of the world
+	Mesh->SetComponentTickInterval(Interval);
+	AppliedRates.Add(Mesh, { Rate, Interval });
+}
\ No newline at end of file
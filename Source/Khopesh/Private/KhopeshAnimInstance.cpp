@@ -1,54 +1,70 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "KhopeshAnimInstance.h"
+#include "Khopesh.h"
+#include "KhopeshAnimBudget.h"
+#include "KhopeshCombatProfile.h"
+#include "KhopeshCountingMalloc.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
-UKhopeshAnimInstance::UKhopeshAnimInstance()
+DECLARE_CYCLE_STAT(TEXT("Anim PreUpdate"), STAT_KhopeshAnimPreUpdate, STATGROUP_Khopesh);
+
+void FKhopeshAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
 {
-	Speed = 0.0f;
-	IsInAir = false;
-	IsCombatMode = false;
+	FAnimInstanceProxy::Initialize(InAnimInstance);
+
+	auto Owner = Cast<ACharacter>(InAnimInstance->TryGetPawnOwner());
+	Movement = Owner ? Owner->GetCharacterMovement() : nullptr;
 }
 
-void UKhopeshAnimInstance::NativeBeginPlay()
+void FKhopeshAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
 {
-	Super::NativeInitializeAnimation();
-
-	MontageMap.Emplace(EMontage::ATTACK_WEAK, AttackWeak);
-	MontageMap.Emplace(EMontage::ATTACK_STRONG, AttackStrong);
-	MontageMap.Emplace(EMontage::DEFENSE, Defense);
-	MontageMap.Emplace(EMontage::DODGE_SHORT, DodgeShort);
-	MontageMap.Emplace(EMontage::DODGE_LONG, DodgeLong);
-	MontageMap.Emplace(EMontage::HIT_FRONT, HitFront);
-	MontageMap.Emplace(EMontage::HIT_LEFT, HitLeft);
-	MontageMap.Emplace(EMontage::HIT_BACK, HitBack);
-	MontageMap.Emplace(EMontage::HIT_RIGHT, HitRight);
-	MontageMap.Emplace(EMontage::BROKEN, Broken);
-	MontageMap.Emplace(EMontage::EQUIP, Equip);
-	MontageMap.Emplace(EMontage::UNEQUIP, Unequip);
-	MontageMap.Emplace(EMontage::DIE, Die);
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshAnimPreUpdate);
+
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Blueprints read them on the game thread too, so they are never written on the worker thread
+	if (auto MovementPtr = Movement.Get())
+	{
+		auto Instance = static_cast<UKhopeshAnimInstance*>(InAnimInstance);
+		Instance->Speed = MovementPtr->Velocity.Size();
+		Instance->IsInAir = MovementPtr->IsFalling();
+	}
 }
 
-void UKhopeshAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+void FKhopeshAnimInstanceProxy::UpdateAnimationNode(float DeltaSeconds)
 {
-	Super::NativeUpdateAnimation(DeltaSeconds);
+	uint32 const StartCycles = FPlatformTime::Cycles();
+	FAnimInstanceProxy::UpdateAnimationNode(DeltaSeconds);
+	FKhopeshAnimBudget::AddWork(FPlatformTime::Cycles() - StartCycles, 1);
+}
 
-	auto Owner = Cast<ACharacter>(TryGetPawnOwner());
-	if (!IsValid(Owner)) return;
+void FKhopeshAnimInstanceProxy::EvaluateAnimationNode(FPoseContext& Output)
+{
+	uint32 const StartCycles = FPlatformTime::Cycles();
+	FAnimInstanceProxy::EvaluateAnimationNode(Output);
+	FKhopeshAnimBudget::AddWork(FPlatformTime::Cycles() - StartCycles, 0);
+}
 
-	Speed = Owner->GetVelocity().Size();
-	IsInAir = Owner->GetCharacterMovement()->IsFalling();
+UKhopeshAnimInstance::UKhopeshAnimInstance()
+{
+	Speed = 0.0f;
+	IsInAir = false;
+	IsCombatMode = false;
+	Profile = nullptr;
 }
 
 void UKhopeshAnimInstance::PlayMontage(EMontage Montage)
 {
-	Montage_Play(MontageMap[Montage]);
+	// The engine creates a montage instance for every play
+	FKhopeshEngineAllocScope EngineAllocScope;
+	Montage_Play(Profile->GetMontage(Montage));
 }
 
 void UKhopeshAnimInstance::JumpToSection(EMontage Montage, FName const& Section)
 {
-	Montage_JumpToSection(Section, MontageMap[Montage]);
+	Montage_JumpToSection(Section, Profile->GetMontage(Montage));
 }
 
 bool UKhopeshAnimInstance::IsMontagePlay() const
@@ -58,13 +74,32 @@ bool UKhopeshAnimInstance::IsMontagePlay() const
 
 bool UKhopeshAnimInstance::IsMontagePlay(EMontage Montage) const
 {
-	return Montage_IsPlaying(MontageMap[Montage]);
+	return Montage_IsPlaying(Profile->GetMontage(Montage));
 }
 
 UAnimMontage* UKhopeshAnimInstance::Get(EMontage Montage) const
 {
-	return MontageMap[Montage];
+	return Profile->GetMontage(Montage);
+}
+
+#if WITH_EDITOR
+void UKhopeshAnimInstance::MigrateLegacyMontages(UKhopeshCombatProfile& OutProfile) const
+{
+	OutProfile.AttackWeak = AttackWeak_DEPRECATED;
+	OutProfile.AttackStrong = AttackStrong_DEPRECATED;
+	OutProfile.Defense = Defense_DEPRECATED;
+	OutProfile.DodgeShort = DodgeShort_DEPRECATED;
+	OutProfile.DodgeLong = DodgeLong_DEPRECATED;
+	OutProfile.HitFront = HitFront_DEPRECATED;
+	OutProfile.HitLeft = HitLeft_DEPRECATED;
+	OutProfile.HitBack = HitBack_DEPRECATED;
+	OutProfile.HitRight = HitRight_DEPRECATED;
+	OutProfile.Broken = Broken_DEPRECATED;
+	OutProfile.Equip = Equip_DEPRECATED;
+	OutProfile.Unequip = Unequip_DEPRECATED;
+	OutProfile.Die = Die_DEPRECATED;
 }
+#endif
 
 void UKhopeshAnimInstance::AnimNotify_Attack()
 {
@@ -73,8 +108,8 @@ void UKhopeshAnimInstance::AnimNotify_Attack()
 
 void UKhopeshAnimInstance::AnimNotify_NextCombo()
 {
-	Montage_Stop(0.25f, AttackWeak);
-	Montage_Stop(0.25f, AttackStrong);
+	Montage_Stop(0.25f, Profile->GetMontage(EMontage::ATTACK_WEAK));
+	Montage_Stop(0.25f, Profile->GetMontage(EMontage::ATTACK_STRONG));
 	OnNextCombo.ExecuteIfBound();
 }
 
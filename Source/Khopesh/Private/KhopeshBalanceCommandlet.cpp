@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshBalanceCommandlet.h"
+#include "Khopesh.h"
+#include "KhopeshCharacter.h"
+#include "KhopeshCombatProfile.h"
+#include "KhopeshDuelSimulator.h"
+
+UKhopeshBalanceCommandlet::UKhopeshBalanceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UKhopeshBalanceCommandlet::Main(FString const& Params)
+{
+	int32 Duels = 1000000;
+	int32 Seed = 0;
+	float HP = 100.0f;
+	FString CharacterPath;
+	FString ProfilePath;
+	FParse::Value(*Params, TEXT("Duels="), Duels);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("HP="), HP);
+	FParse::Value(*Params, TEXT("Character="), CharacterPath);
+	FParse::Value(*Params, TEXT("Profile="), ProfilePath);
+
+	FKhopeshScript Scripts[2];
+	FParse::Value(*Params, TEXT("Attack0="), Scripts[0].AttackChance);
+	FParse::Value(*Params, TEXT("Defense0="), Scripts[0].DefenseChance);
+	FParse::Value(*Params, TEXT("Error0="), Scripts[0].FacingError);
+	FParse::Value(*Params, TEXT("Attack1="), Scripts[1].AttackChance);
+	FParse::Value(*Params, TEXT("Defense1="), Scripts[1].DefenseChance);
+	FParse::Value(*Params, TEXT("Error1="), Scripts[1].FacingError);
+
+	// The stats live in a combat profile, the native character has none
+	UKhopeshCombatProfile const* Profile = nullptr;
+	if (!ProfilePath.IsEmpty())
+	{
+		Profile = LoadObject<UKhopeshCombatProfile>(nullptr, *ProfilePath);
+		if (!Profile)
+		{
+			UE_LOG(LogKhopesh, Error, TEXT("Combat profile %s not found"), *ProfilePath);
+			return 1;
+		}
+	}
+	else if (!CharacterPath.IsEmpty())
+	{
+		UClass* CharacterClass = LoadClass<AKhopeshCharacter>(nullptr, *CharacterPath);
+		if (!CharacterClass)
+		{
+			UE_LOG(LogKhopesh, Error, TEXT("Character class %s not found"), *CharacterPath);
+			return 1;
+		}
+
+		Profile = CharacterClass->GetDefaultObject<AKhopeshCharacter>()->GetCombatProfile();
+		if (!Profile)
+		{
+			UE_LOG(LogKhopesh, Error, TEXT("Character class %s has no combat profile"), *CharacterPath);
+			return 1;
+		}
+	}
+	else
+	{
+		UE_LOG(LogKhopesh, Error, TEXT("Usage : -run=KhopeshBalance Profile=/Game/... or Character=/Game/..."));
+		return 1;
+	}
+
+	FKhopeshStats Stats;
+	Profile->GetStats(Stats);
+
+	FString Error;
+	if (!Stats.Validate(Error))
+	{
+		UE_LOG(LogKhopesh, Error, TEXT("Combat profile %s is not playable : %s"), *Profile->GetPathName(), *Error);
+		return 1;
+	}
+
+	FKhopeshDuelSimulator const Simulator(Stats, HP);
+
+	double const StartTime = FPlatformTime::Seconds();
+	FKhopeshBatchResult const Result = Simulator.SimulateBatch(Scripts, Duels, Seed);
+	double const Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	double const Total = FMath::Max<int64>(Result.Duels, 1);
+
+	UE_LOG(LogKhopesh, Display, TEXT("Balance : %s, %lld duels in %.2f s, %.0f duels per second"),
+		*Profile->GetName(), Result.Duels, Elapsed, Result.Duels / FMath::Max(Elapsed, 1.0e-6));
+	UE_LOG(LogKhopesh, Display, TEXT("Result : %.2f%% / %.2f%% wins, %.2f%% draws, %.2f exchanges per duel"),
+		Result.Wins[0] * 100.0 / Total, Result.Wins[1] * 100.0 / Total, Result.Draws * 100.0 / Total, Result.Exchanges / Total);
+
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		UE_LOG(LogKhopesh, Display, TEXT("Fighter %d : %.2f hits, %.2f parries per duel"),
+			Slot, Result.Hits[Slot] / Total, Result.Parries[Slot] / Total);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshBot.h"
+#include "KhopeshCharacter.h"
+#include "KhopeshCombatProfile.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "EngineUtils.h"
+
+namespace
+{
+	// Seconds between two decisions, about the pace of a player
+	float const DecisionInterval = 0.25f;
+	float const MaxAimError = 30.0f;
+}
+
+FKhopeshBot::FKhopeshBot(EBotStrategy InStrategy, int32 Seed)
+	: Random(Seed), Strategy(InStrategy)
+{
+	switch (Strategy)
+	{
+	case EBotStrategy::AGGRESSIVE:
+		AttackChance = 0.7f;
+		DefenseChance = 0.1f;
+		DodgeChance = 0.05f;
+		break;
+	case EBotStrategy::DEFENSIVE:
+		AttackChance = 0.2f;
+		DefenseChance = 0.5f;
+		DodgeChance = 0.15f;
+		break;
+	default:
+		AttackChance = 0.35f;
+		DefenseChance = 0.25f;
+		DodgeChance = 0.1f;
+		break;
+	}
+
+	DecisionTime = 0.0f;
+	DodgeHoldTime = -1.0f;
+	MoveForward = 0.0f;
+	MoveRight = 0.0f;
+	AimError = 0.0f;
+}
+
+TUniquePtr<FKhopeshBot> FKhopeshBot::CreateFromCommandLine()
+{
+	FString StrategyName;
+	if (!FParse::Param(FCommandLine::Get(), TEXT("KhopeshBot")) && !FParse::Value(FCommandLine::Get(), TEXT("KhopeshBot="), StrategyName))
+		return nullptr;
+
+	EBotStrategy NewStrategy = EBotStrategy::RANDOM;
+	if (StrategyName == TEXT("Aggressive"))
+	{
+		NewStrategy = EBotStrategy::AGGRESSIVE;
+	}
+	else if (StrategyName == TEXT("Defensive"))
+	{
+		NewStrategy = EBotStrategy::DEFENSIVE;
+	}
+
+	int32 Seed = FPlatformProcess::GetCurrentProcessId();
+	FParse::Value(FCommandLine::Get(), TEXT("BotSeed="), Seed);
+
+	return MakeUnique<FKhopeshBot>(NewStrategy, Seed);
+}
+
+void FKhopeshBot::Tick(APlayerController* Controller, float DeltaSeconds)
+{
+	auto Character = Cast<AKhopeshCharacter>(Controller->GetPawn());
+	// A character without a profile never fights
+	if (!Character || !Character->GetCombatProfile() || Character->GetHP() <= 0.0f) return;
+
+	auto Enemy = FindEnemy(Character);
+	if (!Enemy) return;
+
+	// Aim like the mouse would, with an error that decides how often a defense parries
+	FRotator Aim = UKismetMathLibrary::FindLookAtRotation(Character->GetActorLocation(), Enemy->GetActorLocation());
+	Aim.Pitch = 0.0f;
+	Aim.Yaw += AimError;
+	Controller->SetControlRotation(Aim);
+
+	float const Distance = FVector::Dist2D(Character->GetActorLocation(), Enemy->GetActorLocation());
+
+	if ((DecisionTime -= DeltaSeconds) <= 0.0f)
+	{
+		DecisionTime += DecisionInterval;
+		Decide(Character, Distance);
+	}
+
+	if (DodgeHoldTime >= 0.0f && (DodgeHoldTime -= DeltaSeconds) < 0.0f)
+	{
+		Character->OnReleaseDodge();
+	}
+
+	// Axis bindings are called every frame, so are these
+	Character->MoveForward(MoveForward);
+	Character->MoveRight(MoveRight);
+}
+
+void FKhopeshBot::Decide(AKhopeshCharacter* Character, float Distance)
+{
+	AimError = Random.FRandRange(-MaxAimError, MaxAimError);
+
+	// Close in until the attack reaches, then circle
+	MoveForward = (Distance > Character->GetCombatProfile()->AttackRange) ? 1.0f : Random.FRandRange(-0.5f, 0.5f);
+	MoveRight = Random.FRandRange(-1.0f, 1.0f);
+
+	float const Roll = Random.FRand();
+	if (Roll < AttackChance)
+	{
+		Character->Attack();
+	}
+	else if (Roll < AttackChance + DefenseChance)
+	{
+		Character->Defense();
+	}
+	else if (Roll < AttackChance + DefenseChance + DodgeChance && DodgeHoldTime < 0.0f)
+	{
+		// Both short and long dodges
+		Character->OnPressDodge();
+		DodgeHoldTime = Random.FRandRange(0.0f, Character->GetCombatProfile()->DodgeReinforceDelay * 2.0f);
+	}
+}
+
+AKhopeshCharacter* FKhopeshBot::FindEnemy(AKhopeshCharacter* Character) const
+{
+	AKhopeshCharacter* Enemy = nullptr;
+	float MinDistSquared = MAX_flt;
+
+	for (TActorIterator<AKhopeshCharacter> It(Character->GetWorld()); It; ++It)
+	{
+		if (*It == Character || It->GetHP() <= 0.0f) continue;
+
+		float const DistSquared = FVector::DistSquared(Character->GetActorLocation(), It->GetActorLocation());
+		if (DistSquared < MinDistSquared)
+		{
+			MinDistSquared = DistSquared;
+			Enemy = *It;
+		}
+	}
+
+	return Enemy;
+}
\ No newline at end of file
@@ -1,10 +1,13 @@
 // Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "KhopeshCharacter.h"
+#include "Khopesh.h"
 #include "KhopeshPlayerController.h"
 #include "KhopeshAnimInstance.h"
+#include "KhopeshCombatProfile.h"
+#include "KhopeshGameMode.h"
+#include "KhopeshMovementComponent.h"
 #include "UnrealNetwork.h"
-#include "TimerManager.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -15,8 +18,29 @@
 #include "GameFramework/Controller.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/GameplayStatics.h"
-
-AKhopeshCharacter::AKhopeshCharacter()
+#include "GameFramework/GameStateBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Tick"), STAT_KhopeshCharacterTick, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Set Enemy Near"), STAT_KhopeshSetEnemyNear, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("On Attack"), STAT_KhopeshOnAttack, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Take Damage"), STAT_KhopeshTakeDamage, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Attack_Request"), STAT_KhopeshAttackRequest, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Attack_Response"), STAT_KhopeshAttackResponse, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Defense_Request"), STAT_KhopeshDefenseRequest, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Defense_Response"), STAT_KhopeshDefenseResponse, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("ShowCombatEffect"), STAT_KhopeshShowCombatEffect, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("PlayCombatEvents"), STAT_KhopeshPlayCombatEvents, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("PlayEquip"), STAT_KhopeshPlayEquip, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("SetWeapon"), STAT_KhopeshSetWeapon, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("PlayDie"), STAT_KhopeshPlayDie, STATGROUP_Khopesh);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Ticked"), STAT_KhopeshCharactersTicked, STATGROUP_Khopesh);
+
+// Looked up once instead of on every defense
+static FName const DefenseSuccessSection(TEXT("Success"));
+static FName const DefenseFailSection(TEXT("Fail"));
+
+AKhopeshCharacter::AKhopeshCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UKhopeshMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 
@@ -50,62 +74,232 @@ AKhopeshCharacter::AKhopeshCharacter()
 	RightWeapon->CanCharacterStepUpOn = ECanBeCharacterBase::ECB_No;
 	RightWeapon->SetCollisionProfileName(TEXT("NoCollision"));
 	RightWeapon->SetGenerateOverlapEvents(false);
+
+	AttackRewindDelay = 0.0f;
+
+	// Outside a match, combat multicasts only go to connections near the character, see IsNetRelevantFor
+	NetCullDistanceSquared = FMath::Square(5000.0f);
+	IsEnemyNear = false;
+	IsRollbackDuel = false;
+}
+
+void AKhopeshCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+#if WITH_EDITOR
+	// Plays as it was saved until the blueprint is migrated. A cook drops the old tuning, see PreSave.
+	if (!Profile && HasLegacyTuning())
+	{
+		UE_LOG(LogKhopesh, Warning, TEXT("%s was saved before the combat profiles, run -run=KhopeshProfileMigration"), *GetClass()->GetName());
+		Profile = NewObject<UKhopeshCombatProfile>(this, NAME_None, RF_Transient);
+		MigrateLegacyTuning(*Profile);
+	}
+#endif
+
+	if (!ensureMsgf(Profile, TEXT("%s has no combat profile, using DefaultProfile"), *GetClass()->GetName()))
+	{
+		Profile = DefaultProfile.LoadSynchronous();
+	}
+
+	if (!Profile)
+	{
+		UE_LOG(LogKhopesh, Error, TEXT("%s has no combat profile and no DefaultProfile, it will not fight"), *GetName());
+		return;
+	}
+
+	// Before any replicated status is received. A profile saved before the editor clamp may be above what is sent.
+	HP = FMath::Min(Profile->HP, FKhopeshStatus::MaxHP);
+}
+
+#if WITH_EDITOR
+void AKhopeshCharacter::PreSave(ITargetPlatform const* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	// Cooked data has no deprecated properties, the character would never fight
+	if (TargetPlatform && HasAnyFlags(RF_ClassDefaultObject) && !Profile && HasLegacyTuning())
+	{
+		UE_LOG(LogKhopesh, Error, TEXT("%s is cooked without its tuning, run -run=KhopeshProfileMigration first"), *GetClass()->GetName());
+	}
 }
 
+bool AKhopeshCharacter::HasLegacyTuning() const
+{
+	// Every playable blueprint had at least one combo
+	return MaxCombo_DEPRECATED > 0;
+}
+
+void AKhopeshCharacter::MigrateLegacyTuning(UKhopeshCombatProfile& OutProfile) const
+{
+	OutProfile.HP = FMath::Min(HP, FKhopeshStatus::MaxHP);
+	OutProfile.CombatSwapRange = CombatSwapRange_DEPRECATED;
+	OutProfile.AttackRange = AttackRange_DEPRECATED;
+	OutProfile.AttackRadius = AttackRadius_DEPRECATED;
+	OutProfile.WeakAttackDamage = WeakAttackDamage_DEPRECATED;
+	OutProfile.StrongAttackDamage = StrongAttackDamage_DEPRECATED;
+	OutProfile.MaxCombo = MaxCombo_DEPRECATED;
+	OutProfile.ComboDuration = ComboDuration_DEPRECATED;
+	OutProfile.DefenseDuration = DefenseDuration_DEPRECATED;
+	OutProfile.BrokenDuration = BrokenDuration_DEPRECATED;
+	OutProfile.DodgeDelay = DodgeDelay_DEPRECATED;
+	OutProfile.ReadySpeed = ReadySpeed_DEPRECATED;
+	OutProfile.FightSpeed = FightSpeed_DEPRECATED;
+	OutProfile.SpeedRate = SpeedRate_DEPRECATED;
+	OutProfile.DodgeReinforceDelay = DodgeReinforceDelay_DEPRECATED;
+	OutProfile.HitKnockBackImpulse = HitKnockBackImpulse_DEPRECATED;
+	OutProfile.WeakAttackHitNum = WeakAttackHitNum_DEPRECATED;
+	OutProfile.StrongAttackHitNum = StrongAttackHitNum_DEPRECATED;
+
+	auto AnimDefaults = GetMesh()->AnimClass ? Cast<UKhopeshAnimInstance>(GetMesh()->AnimClass->GetDefaultObject()) : nullptr;
+	if (AnimDefaults)
+	{
+		AnimDefaults->MigrateLegacyMontages(OutProfile);
+	}
+
+	OutProfile.BuildTables();
+}
+#endif
+
 void AKhopeshCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
 	Anim = Cast<UKhopeshAnimInstance>(GetMesh()->GetAnimInstance());
 
+	if (IsRunningDedicatedServer())
+	{
+		// Montages carry the gameplay notifies, the rest of the graph is only seen by clients.
+		// Bones are still refreshed while a swing is traced.
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+
+		// Nobody looks through the camera, and the boom would sweep every frame. The components stay in every build,
+		// so that blueprints and saved instances keep the same layout.
+		CameraBoom->SetComponentTickEnabled(false);
+		FollowCamera->UnregisterComponent();
+		CameraBoom->UnregisterComponent();
+	}
+
+	DefaultAnimTickOption = GetMesh()->VisibilityBasedAnimTickOption;
+
+	// Never enters combat, so nothing else reads the missing profile
+	if (!Profile)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	Profile->LoadMontages();
+	Anim->SetProfile(Profile);
+
 	UAnimMontage* BrokenMontage = Anim->Get(EMontage::BROKEN);
-	BrokenPlayRate = BrokenMontage->GetPlayLength() / BrokenDuration;
+	BrokenPlayRate = BrokenMontage->GetPlayLength() / Profile->BrokenDuration;
 
 	if (!HasAuthority()) return;
 
+	RewindBuffer.Init(Profile->RewindBufferSize);
+
 	Anim->OnAttack.BindUObject(this, &AKhopeshCharacter::OnAttack);
 	Anim->OnSetCombatMode.BindUObject(this, &AKhopeshCharacter::SetCombat);
-	Anim->OnNextCombo.BindLambda([this]()
+	Anim->OnNextCombo.BindUObject(this, &AKhopeshCharacter::OnNextCombo);
+
+	GetCharacterMovement()->MaxWalkSpeed = Speed = Profile->ReadySpeed;
+	MarkStatusDirty();
+	GetCapsuleComponent()->TransformUpdated.AddUObject(this, &AKhopeshCharacter::OnCapsuleMoved);
+}
+
+void AKhopeshCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	if (GameMode)
 	{
-		GetWorldTimerManager().SetTimer(ComboTimer, [this]()
-		{
-			CurrentCombo = 0;
-		}, ComboDuration, false);
-	});
+		GameMode->GetProximityGrid().Remove(this);
+	}
+}
+
+void AKhopeshCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+	if (!Profile) return;
 
-	GetCharacterMovement()->MaxWalkSpeed = Speed = ReadySpeed;
+	// Only opponents of the same match can trigger the combat mode
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	if (GameMode)
+	{
+		float const Radius = GetCapsuleComponent()->GetScaledCapsuleRadius();
+		GameMode->GetProximityGrid().Add(this, Profile->CombatSwapRange, Radius, GameMode->GetMatchIndex(NewController));
+		GameMode->StartDuel(NewController);
+	}
 }
 
 void AKhopeshCharacter::Tick(float DeltaSeconds)
 {
-	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshCharacterTick);
+	CSV_SCOPED_TIMING_STAT(Khopesh, CharacterTick);
 
-	GetCharacterMovement()->MaxWalkSpeed = FMath::Lerp(
-		GetCharacterMovement()->MaxWalkSpeed,
-		Speed, DeltaSeconds * SpeedRate);
+	Super::Tick(DeltaSeconds);
 
-	if (!HasAuthority() || Anim->IsMontagePlay())
-		return;
+	INC_DWORD_STAT(STAT_KhopeshCharactersTicked);
+	CSV_CUSTOM_STAT(Khopesh, CharactersTicked, 1, ECsvCustomStatOp::Accumulate);
 
-	bool IsCombat = IsEnemyNear();
+	// Snaps once close, so that the transition has an end
+	float const MaxWalkSpeed = FMath::Lerp(GetCharacterMovement()->MaxWalkSpeed, Speed, FMath::Min(DeltaSeconds * Profile->SpeedRate, 1.0f));
+	GetCharacterMovement()->MaxWalkSpeed = FMath::IsNearlyEqual(MaxWalkSpeed, Speed, 1.0f) ? Speed : MaxWalkSpeed;
 
-	if (IsCombat && !IsCombatMode)
+	if (HasAuthority() && !IsRollbackDuel)
 	{
-		PlayEquip(true);
-	}
-	else if (!IsCombat && IsCombatMode)
-	{
-		PlayEquip(false);
+		// Segments queued last frame first, then the blades of this frame for the next one
+		if (Swing.IsActive())
+		{
+			ResolveSwing();
+			Swing.Record(GetBladeSample());
+
+			if (!Swing.IsActive())
+			{
+				GetMesh()->VisibilityBasedAnimTickOption = DefaultAnimTickOption;
+			}
+		}
+
+		FlushCombatEvents();
+		RewindBuffer.Record(GetWorld()->GetTimeSeconds(), GetActorLocation(), GetActorRotation());
+
+		// Equip change requested by the proximity grid while a montage was playing
+		if (IsEnemyNear != IsCombatMode && !Anim->IsMontagePlay())
+		{
+			PlayEquip(IsEnemyNear);
+		}
 	}
+
+	UpdateTickInterval();
 }
 
 void AKhopeshCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AKhopeshCharacter, HP);
-	DOREPLIFETIME(AKhopeshCharacter, Speed);
-	DOREPLIFETIME(AKhopeshCharacter, IsCombatMode);
+	// Every received status is a change, see MarkStatusDirty
+	DOREPLIFETIME_CONDITION_NOTIFY(AKhopeshCharacter, Status, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION(AKhopeshCharacter, IsStartCombat, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AKhopeshCharacter, LastDodge, COND_SkipOwner);
+	DOREPLIFETIME(AKhopeshCharacter, Duel);
+}
+
+void AKhopeshCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	RepTracker.Update(this, AKhopeshCharacter::StaticClass());
+}
+
+bool AKhopeshCharacter::IsNetRelevantFor(AActor const* RealViewer, AActor const* ViewTarget, FVector const& SrcLocation) const
+{
+	// Without the replication graph, a fighter is only seen by the players of its own match
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	int32 const MatchIndex = GameMode ? GameMode->GetMatchIndex(GetController()) : INDEX_NONE;
+	if (MatchIndex == INDEX_NONE) return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+
+	return GameMode->GetMatchIndex(Cast<AController>(RealViewer)) == MatchIndex;
 }
 
 void AKhopeshCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -128,32 +322,255 @@ void AKhopeshCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 float AKhopeshCharacter::TakeDamage(
 	float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
-	if (IsDefensing && FMath::Abs(GetActorRotation().Yaw - DamageCauser->GetActorRotation().Yaw) >= 112.5f)
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshTakeDamage);
+
+	auto Attacker = Cast<AKhopeshCharacter>(DamageCauser);
+
+	FVector DefenseLocation;
+	FRotator DefenseRotation;
+	GetRewoundTransform(Attacker->GetAttackRewindTime(), DefenseLocation, DefenseRotation);
+
+	if (Combat.IsDefensing && FKhopeshRules::IsParried(DefenseRotation.Yaw, Attacker->GetActorRotation().Yaw))
 	{
-		Break(Cast<AKhopeshCharacter>(DamageCauser));
+		Break(Attacker);
 		return 0.0f;
 	}
 
 	float FinalDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
-	HP = FMath::Clamp<float>(HP - FinalDamage, 0.0f, 100.0f);
-	Cast<AKhopeshCharacter>(DamageCauser)->ApplyEnemyHP(HP);
-	ShowHitEffect();
-	PlayHitSound();
+	HP = FMath::Clamp<float>(HP - FinalDamage, 0.0f, FKhopeshStatus::MaxHP);
+	MarkStatusDirty();
+
+	FKhopeshCombatEvent HitEvent;
+	HitEvent.Type = ECombatEvent::HIT;
+	HitEvent.Montage = static_cast<uint8>(EMontage::DIE);
 
 	if (HP > 0.0f)
 	{
-		auto Dir = GetActorRotation().Yaw - DamageCauser->GetActorRotation().Yaw;
-		Dir = (FMath::Abs(Dir) > 180.0f) ? (Dir - (360.0f * FMath::Sign(Dir))) : Dir;
-		GetCharacterMovement()->AddImpulse(DamageCauser->GetActorForwardVector() * HitKnockBackImpulse, true);
-		PlayHitMontage(GetHitMontageByDir(Dir));
+		auto Direction = FKhopeshRules::GetHitDirection(GetActorRotation().Yaw, DamageCauser->GetActorRotation().Yaw);
+		GetCharacterMovement()->AddImpulse(DamageCauser->GetActorForwardVector() * Profile->HitKnockBackImpulse, true);
+		HitEvent.Montage = static_cast<uint8>(GetHitMontage(Direction));
+		PushCombatEvent(HitEvent);
+	}
+	else
+	{
+		// Send the last hit before PlayDie
+		PushCombatEvent(HitEvent);
+		FlushCombatEvents();
+		Die();
 	}
-	else { Die(); }
 
 	return FinalDamage;
 }
 
+bool AKhopeshCharacter::CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack)
+{
+	if (auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>())
+	{
+		GameMode->GetLoadRecorder().CountSentRPC();
+	}
+
+	FKhopeshNetAccounting::RecordRPC(this, Function, Parameters);
+	return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+}
+
+void AKhopeshCharacter::SetEnemyNear(bool IsNear)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshSetEnemyNear);
+
+	IsEnemyNear = IsNear;
+	WakeTick();
+
+	if (IsEnemyNear != IsCombatMode && !Anim->IsMontagePlay())
+	{
+		PlayEquip(IsEnemyNear);
+	}
+}
+
+void AKhopeshCharacter::StepCombat()
+{
+	// Only the defense window has a visible end
+	if (Combat.Step() & ECombatWindow::DEFENSE)
+	{
+		FKhopeshCombatEvent Event;
+		Event.Type = ECombatEvent::DEFENSE_FAIL;
+		PushCombatEvent(Event);
+	}
+}
+
+void AKhopeshCharacter::StartDuel(FKhopeshDuel const& NewDuel)
+{
+	Duel = NewDuel;
+	OnRep_Duel();
+}
+
+void AKhopeshCharacter::GetStats(FKhopeshStats& OutStats) const
+{
+	Profile->GetStats(OutStats);
+}
+
+void AKhopeshCharacter::GetDuelRules(FKhopeshDuelRules& OutRules) const
+{
+	OutRules.MoveSpeed = Profile->FightSpeed;
+	OutRules.CapsuleRadius = GetCapsuleComponent()->GetScaledCapsuleRadius();
+	OutRules.AttackRange = Profile->AttackRange;
+	OutRules.AttackRadius = Profile->AttackRadius;
+
+	GetStats(OutRules.Stats);
+
+	OutRules.ComboFrames = FKhopeshCombatState::ToFrames(Profile->ComboDuration);
+	OutRules.DefenseFrames = FKhopeshCombatState::ToFrames(Profile->DefenseDuration);
+	OutRules.BrokenFrames = FKhopeshCombatState::ToFrames(Profile->BrokenDuration);
+	OutRules.DodgeDelayFrames = FKhopeshCombatState::ToFrames(Profile->DodgeDelay);
+	OutRules.DodgeReinforceFrames = FKhopeshCombatState::ToFrames(Profile->DodgeReinforceDelay);
+
+	for (int32 Idx = 0; Idx < OutRules.MontageFrames.Num(); ++Idx)
+	{
+		if (static_cast<EMontage>(Idx) == EMontage::START) continue;
+		OutRules.MontageFrames[Idx] = FKhopeshCombatState::ToFrames(Anim->Get(static_cast<EMontage>(Idx))->GetPlayLength());
+	}
+
+	// Broken is played faster to fit in BrokenDuration
+	OutRules.MontageFrames[static_cast<int32>(EMontage::BROKEN)] = OutRules.BrokenFrames;
+
+	for (int32 Idx = 0; Idx < 2; ++Idx)
+	{
+		UAnimMontage* DodgeMontage = Anim->Get(Idx ? EMontage::DODGE_LONG : EMontage::DODGE_SHORT);
+		FTransform const RootMotion = DodgeMontage->ExtractRootMotionFromTrackRange(0.0f, DodgeMontage->GetPlayLength());
+		OutRules.DodgeDistance[Idx] = RootMotion.GetTranslation().Size2D();
+
+		// Every combo section of an attack montage hits at its Attack notify
+		UAnimMontage* AttackMontage = Anim->Get(Idx ? EMontage::ATTACK_STRONG : EMontage::ATTACK_WEAK);
+		OutRules.AttackTimings[Idx].SetNum(Profile->MaxCombo);
+
+		for (int32 Combo = 1; Combo <= Profile->MaxCombo; ++Combo)
+		{
+			float Start, End;
+			AttackMontage->GetSectionStartAndEndTime(AttackMontage->GetSectionIndex(Profile->GetComboSection(Combo)), Start, End);
+
+			float HitTime = Start;
+			for (FAnimNotifyEvent const& Notify : AttackMontage->Notifies)
+			{
+				float const Time = Notify.GetTriggerTime();
+				if (Notify.NotifyName == TEXT("Attack") && Time >= Start && Time < End)
+				{
+					HitTime = Time;
+					break;
+				}
+			}
+
+			FKhopeshAttackTiming& Timing = OutRules.AttackTimings[Idx][Combo - 1];
+			Timing.StartTime = Start;
+			Timing.HitFrame = FMath::Max<uint16>(FKhopeshCombatState::ToFrames(HitTime - Start), 1);
+			Timing.Frames = FKhopeshCombatState::ToFrames(End - Start);
+		}
+	}
+}
+
+FKhopeshDuelInput AKhopeshCharacter::ConsumeDuelInput()
+{
+	FKhopeshDuelInput Input = PendingDuelInput;
+	Input.Yaw = FKhopeshYaw(GetRotationByAim().Yaw);
+
+	// Presses are sent once, the dodge key stays held
+	PendingDuelInput.Buttons &= EDuelButton::DODGE;
+	return Input;
+}
+
+void AKhopeshCharacter::ApplyDuelState(FKhopeshFighterState const& State, FKhopeshDuelRules const& Rules)
+{
+	FKhopeshFighterState const Previous = AppliedDuelState;
+	AppliedDuelState = State;
+
+	SetActorLocationAndRotation(State.Location, FRotator(0.0f, State.Yaw, 0.0f));
+
+	bool const IsRestarted = State.Montage != Previous.Montage || State.MontageFrame < Previous.MontageFrame;
+
+	// Changes are turned into the same events the server authoritative mode sends
+	FKhopeshCombatEvent Event;
+
+	// The shown HP follows the simulation both ways, a rollback may undo a predicted hit
+	if (State.HP != HP)
+	{
+		HP = State.HP;
+
+		if (HasAuthority())
+		{
+			MarkStatusDirty();
+		}
+		else
+		{
+			ApplyHP();
+		}
+	}
+
+	if (State.HP < Previous.HP)
+	{
+		Event.Type = ECombatEvent::HIT;
+		Event.Montage = (HP > 0.0f) ? State.Montage : static_cast<uint8>(EMontage::DIE);
+		ApplyCombatEvent(Event);
+
+		if (HP <= 0.0f && HasAuthority())
+		{
+			Die();
+		}
+	}
+	else if (IsRestarted && State.Montage == FKhopeshFighterState::NoMontage)
+	{
+		Anim->Montage_Stop(0.25f);
+	}
+	else if (IsRestarted && State.Montage == static_cast<uint8>(EMontage::BROKEN))
+	{
+		Event.Type = ECombatEvent::BROKEN;
+		ApplyCombatEvent(Event);
+	}
+	else if (IsRestarted)
+	{
+		EMontage const Montage = static_cast<EMontage>(State.Montage);
+		Anim->PlayMontage(Montage);
+
+		if (Montage == EMontage::ATTACK_WEAK || Montage == EMontage::ATTACK_STRONG)
+		{
+			Anim->JumpToSection(Montage, Profile->GetComboSection(State.Combat.Combo));
+		}
+	}
+
+	if (Previous.Combat.IsDefensing && !State.Combat.IsDefensing && State.HP == Previous.HP)
+	{
+		Event.Type = (State.Combat.IsStrongMode && !Previous.Combat.IsStrongMode) ? ECombatEvent::DEFENSE_SUCCESS : ECombatEvent::DEFENSE_FAIL;
+		Event.Yaw = FKhopeshYaw(State.Yaw);
+		ApplyCombatEvent(Event);
+	}
+
+	if (State.Montage == FKhopeshFighterState::NoMontage || HP <= 0.0f) return;
+
+	// Pull the montage back in line after a rollback changed its start
+	EMontage const Montage = static_cast<EMontage>(State.Montage);
+	UAnimMontage* MontageAsset = Anim->Get(Montage);
+	float Position = State.MontageFrame * Rules.FrameTime;
+
+	if (Montage == EMontage::ATTACK_WEAK || Montage == EMontage::ATTACK_STRONG)
+	{
+		Position += Rules.AttackTimings[Montage == EMontage::ATTACK_STRONG][State.Combat.Combo - 1].StartTime;
+	}
+	else if (Montage == EMontage::BROKEN)
+	{
+		Position *= BrokenPlayRate;
+	}
+
+	if (Anim->Montage_IsPlaying(MontageAsset) && FMath::Abs(Anim->Montage_GetPosition(MontageAsset) - Position) > Rules.FrameTime * 2.0f)
+	{
+		Anim->Montage_SetPosition(MontageAsset, Position);
+	}
+}
+
 void AKhopeshCharacter::MoveForward(float Value)
 {
+	if (IsRollbackDuel)
+	{
+		PendingDuelInput.MoveForward = static_cast<int8>(FMath::RoundToInt(Value * 127.0f));
+		return;
+	}
+
 	if (Controller && Value != 0.0f)
 	{
 		Move(EAxis::X, Value);
@@ -162,6 +579,12 @@ void AKhopeshCharacter::MoveForward(float Value)
 
 void AKhopeshCharacter::MoveRight(float Value)
 {
+	if (IsRollbackDuel)
+	{
+		PendingDuelInput.MoveRight = static_cast<int8>(FMath::RoundToInt(Value * 127.0f));
+		return;
+	}
+
 	if (Controller && Value != 0.0f)
 	{
 		Move(EAxis::Y, Value);
@@ -170,206 +593,208 @@ void AKhopeshCharacter::MoveRight(float Value)
 
 void AKhopeshCharacter::Attack()
 {
-	Attack_Request(GetRotationByAim());
+	if (IsRollbackDuel)
+	{
+		PendingDuelInput.Buttons |= EDuelButton::ATTACK;
+		return;
+	}
+
+	auto GameState = GetWorld()->GetGameState();
+	float const InputTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	Attack_Request(FKhopeshYaw(GetRotationByAim().Yaw), InputTime);
 }
 
 void AKhopeshCharacter::Defense()
 {
-	Defense_Request(GetRotationByAim());
+	if (IsRollbackDuel)
+	{
+		PendingDuelInput.Buttons |= EDuelButton::DEFENSE;
+		return;
+	}
+
+	Defense_Request(FKhopeshYaw(GetRotationByAim().Yaw));
 }
 
 void AKhopeshCharacter::OnPressDodge()
 {
-	if (IsCombatMode)
+	if (IsRollbackDuel)
 	{
-		IsReadyDodge = true;
-
-		GetWorldTimerManager().SetTimer(DodgeTimer, [this]
-		{
-			Dodge_Request(GetRotationByInputKey(), true);
-			IsReadyDodge = false;
-		}, DodgeReinforceDelay, false);
-	}
-	else
-	{
-		Dodge_Request(GetRotationByInputKey(), true);
+		PendingDuelInput.Buttons |= EDuelButton::DODGE;
+		return;
 	}
+
+	// Short and long dodge are resolved by the movement component, see UKhopeshMovementComponent::UpdateDodge
+	Cast<UKhopeshMovementComponent>(GetCharacterMovement())->SetDodgeHeld(true);
 }
 
 void AKhopeshCharacter::OnReleaseDodge()
 {
-	if (IsCombatMode && IsReadyDodge)
+	if (IsRollbackDuel)
 	{
-		Dodge_Request(GetRotationByInputKey(), false);
-		GetWorldTimerManager().ClearTimer(DodgeTimer);
-		IsReadyDodge = false;
+		PendingDuelInput.Buttons &= static_cast<uint8>(~EDuelButton::DODGE);
+		return;
 	}
+
+	Cast<UKhopeshMovementComponent>(GetCharacterMovement())->SetDodgeHeld(false);
 }
 
 void AKhopeshCharacter::OnAttack()
 {
-	FHitResult Out;
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshOnAttack);
 
-	GetWorld()->SweepSingleByObjectType(
-		Out,
-		GetActorLocation(),
-		GetActorLocation() + GetActorForwardVector() * AttackRange,
-		FQuat::Identity,
-		ECollisionChannel::ECC_GameTraceChannel1,
-		FCollisionShape::MakeSphere(AttackRadius),
-		FCollisionQueryParams(NAME_None, false, this)
-	);
+	// Hits of a rollback duel are resolved by the simulation
+	if (IsRollbackDuel || !Profile) return;
 
-	if (Out.bBlockingHit)
-	{
-		bool IsStrongAttack = Anim->IsMontagePlay(EMontage::ATTACK_STRONG);
-		float AttackDamage = IsStrongAttack ? StrongAttackDamage : WeakAttackDamage;
-		auto const& HitNum = IsStrongAttack ? StrongAttackHitNum : WeakAttackHitNum;
+	bool IsStrongAttack = Anim->IsMontagePlay(EMontage::ATTACK_STRONG);
+	float const AttackDamage = IsStrongAttack
+		? FKhopeshRules::GetHitDamage(Profile->StrongAttackDamage, Profile->StrongAttackHitNum, Combat.Combo)
+		: FKhopeshRules::GetHitDamage(Profile->WeakAttackDamage, Profile->WeakAttackHitNum, Combat.Combo);
 
-		int32 Idx = CurrentCombo - 1;
-		if (Idx < 0) Idx = HitNum.Num() - 1;
+	// A swing cut short by the next one still lands what it already swept
+	if (Swing.IsActive())
+	{
+		ResolveSwing();
+	}
 
-		AttackDamage /= HitNum[Idx];
-		Out.GetActor()->TakeDamage(AttackDamage, FDamageEvent(), GetController(), this);
+	// The dedicated server only refreshes bones, and so the blade sockets, while a swing is traced.
+	// The notify fires from a tick that left them stale, so the first sample needs a refresh of its own.
+	USkeletalMeshComponent* Mesh = GetMesh();
+	if (Mesh->VisibilityBasedAnimTickOption != EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones)
+	{
+		Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		Mesh->RefreshBoneTransforms();
 	}
+
+	Swing.Start(GetBladeSample(), Profile->SwingDuration, Profile->TraceSubstepRate, AttackDamage);
+	WakeTick();
+}
+
+void AKhopeshCharacter::OnNextCombo()
+{
+	Combat.StartComboWindow(FKhopeshCombatState::ToFrames(Profile->ComboDuration));
 }
 
 void AKhopeshCharacter::SetCombat(bool IsCombat)
 {
 	SetWeapon(IsCombat);
 	IsCombatMode = IsCombat;
-	CurrentCombo = 0;
+	Combat.ResetCombo();
 
 	if (!IsStartCombat && IsCombat)
 	{
-		Speed = FightSpeed;
+		Speed = Profile->FightSpeed;
 		IsStartCombat = true;
 		ShowCombatEffect();
 	}
-}
 
-void AKhopeshCharacter::Attack_Request_Implementation(FRotator NewRotation)
-{
-	if (!IsCombatMode || Anim->IsMontagePlay()) return;
-
-	EMontage Montage = IsStrongMode ? EMontage::ATTACK_STRONG : EMontage::ATTACK_WEAK;
-	FName Section = *FString::Printf(TEXT("Attack_%d"), ++CurrentCombo);
-	Attack_Response(Montage, Section, NewRotation);
-	GetWorldTimerManager().ClearTimer(ComboTimer);
-	CurrentCombo %= MaxCombo;
-	IsStrongMode = false;
+	MarkStatusDirty();
+	WakeTick();
 }
 
-bool AKhopeshCharacter::Attack_Request_Validate(FRotator NewRotation)
+void AKhopeshCharacter::OnCapsuleMoved(USceneComponent* Component, EUpdateTransformFlags Flags, ETeleportType Teleport)
 {
-	return true;
-}
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	if (GameMode)
+	{
+		GameMode->GetProximityGrid().MarkMoved(this);
+	}
 
-void AKhopeshCharacter::Attack_Response_Implementation(EMontage Montage, FName Section, FRotator NewRotation)
-{
-	SetActorRotation(NewRotation);
-	Anim->PlayMontage(Montage);
-	Anim->JumpToSection(Montage, Section);
+	// The rewind buffer needs every frame of a move
+	WakeTick();
 }
 
-void AKhopeshCharacter::Defense_Request_Implementation(FRotator NewRotation)
+void AKhopeshCharacter::Attack_Request_Implementation(FKhopeshYaw NewYaw, float InputTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshAttackRequest);
+
+	GetWorld()->GetAuthGameMode<AKhopeshGameMode>()->GetLoadRecorder().CountReceivedRPC();
 	if (!IsCombatMode || Anim->IsMontagePlay()) return;
 
-	Defense_Response(NewRotation);
-	IsDefensing = true;
+	AttackRewindDelay = FMath::Clamp(GetWorld()->GetTimeSeconds() - InputTime, 0.0f, Profile->MaxRewindTime);
 
-	GetWorldTimerManager().SetTimer(DefenseTimer, [this]()
-	{
-		EndDefenseMontage(false);
-		IsDefensing = false;
-	}, DefenseDuration, false);
+	EMontage Montage = Combat.IsStrongMode ? EMontage::ATTACK_STRONG : EMontage::ATTACK_WEAK;
+	Attack_Response(Montage, Combat.StartAttack(Profile->MaxCombo), NewYaw);
 }
 
-bool AKhopeshCharacter::Defense_Request_Validate(FRotator NewRotation)
+bool AKhopeshCharacter::Attack_Request_Validate(FKhopeshYaw NewYaw, float InputTime)
 {
 	return true;
 }
 
-void AKhopeshCharacter::Defense_Response_Implementation(FRotator NewRotation)
-{
-	SetActorRotation(NewRotation);
-	Anim->PlayMontage(EMontage::DEFENSE);
-}
-
-void AKhopeshCharacter::Dodge_Request_Implementation(FRotator NewRotation, bool IsLongDodge)
+void AKhopeshCharacter::Attack_Response_Implementation(EMontage Montage, uint8 Combo, FKhopeshYaw NewYaw)
 {
-	if (!IsStartCombat || !CanDodge() || Anim->IsMontagePlay() || GetCharacterMovement()->IsFalling())
-		return;
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshAttackResponse);
 
-	Dodge_Response(NewRotation, IsLongDodge);
-	NextDodgeTime = GetWorld()->GetTimeSeconds() + DodgeDelay;
-}
+	SetActorYaw(NewYaw);
+	Anim->PlayMontage(Montage);
 
-bool AKhopeshCharacter::Dodge_Request_Validate(FRotator NewRotation, bool IsLongDodge)
-{
-	return true;
+	// Same as "Attack_%d" without building a string
+	Anim->JumpToSection(Montage, Profile->GetComboSection(Combo));
 }
 
-void AKhopeshCharacter::Dodge_Response_Implementation(FRotator NewRotation, bool IsLongDodge)
+void AKhopeshCharacter::Defense_Request_Implementation(FKhopeshYaw NewYaw)
 {
-	SetActorRotation(NewRotation);
-	Anim->PlayMontage(IsLongDodge ? EMontage::DODGE_LONG : EMontage::DODGE_SHORT);
-}
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshDefenseRequest);
 
-void AKhopeshCharacter::ShowCombatEffect_Implementation()
-{
-	OnShowCombatEffect();
-}
+	GetWorld()->GetAuthGameMode<AKhopeshGameMode>()->GetLoadRecorder().CountReceivedRPC();
+	if (!IsCombatMode || Anim->IsMontagePlay()) return;
 
-void AKhopeshCharacter::ShowHitEffect_Implementation()
-{
-	OnShowHitEffect();
+	Defense_Response(NewYaw);
+	Combat.StartDefense(FKhopeshCombatState::ToFrames(Profile->DefenseDuration));
 }
 
-void AKhopeshCharacter::ShowParryingEffect_Implementation()
+bool AKhopeshCharacter::Defense_Request_Validate(FKhopeshYaw NewYaw)
 {
-	OnShowParryingEffect();
+	return true;
 }
 
-void AKhopeshCharacter::ApplyEnemyHP_Implementation(float HP)
+void AKhopeshCharacter::Defense_Response_Implementation(FKhopeshYaw NewYaw)
 {
-	OnApplyEnemyHP(HP);
-}
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshDefenseResponse);
 
-void AKhopeshCharacter::PlayHitSound_Implementation()
-{
-	OnPlayHitSound();
+	SetActorYaw(NewYaw);
+	Anim->PlayMontage(EMontage::DEFENSE);
 }
 
-void AKhopeshCharacter::PlayHitMontage_Implementation(EMontage Montage)
+void AKhopeshCharacter::ShowCombatEffect_Implementation()
 {
-	Anim->PlayMontage(Montage);
-}
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshShowCombatEffect);
 
-void AKhopeshCharacter::EndDefenseMontage_Implementation(bool IsSuccess, FRotator Rotator)
-{
-	Anim->JumpToSection(EMontage::DEFENSE, IsSuccess ? TEXT("Success") : TEXT("Fail"));
+	if (IsRunningDedicatedServer()) return;
 
-	if (IsSuccess)
+	if (!PlayEffect(ECombatEffect::COMBAT))
 	{
-		SetActorRotation(Rotator);
+		OnShowCombatEffect();
 	}
 }
 
-void AKhopeshCharacter::PlayBroken_Implementation()
+void AKhopeshCharacter::PlayCombatEvents_Implementation(FKhopeshCombatEvents const& Events)
 {
-	Anim->PlayMontage(EMontage::BROKEN);
-	Anim->Montage_SetPlayRate(Anim->Get(EMontage::BROKEN), BrokenPlayRate);
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshPlayCombatEvents);
+
+	// Server already applied these when they were pushed
+	if (HasAuthority()) return;
+
+	for (FKhopeshCombatEvent const& Event : Events.Events)
+	{
+		ApplyCombatEvent(Event);
+	}
 }
 
 void AKhopeshCharacter::PlayEquip_Implementation(bool IsEquip)
 {
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshPlayEquip);
+
 	Anim->PlayMontage(IsEquip ? EMontage::EQUIP : EMontage::UNEQUIP);
 }
 
 void AKhopeshCharacter::SetWeapon_Implementation(bool IsEquip)
 {
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshSetWeapon);
+
+	// The server only needs the weapons where the swing trace samples them
+	if (IsRunningDedicatedServer() && !HasBladeSockets()) return;
+
 	FName LeftWeaponSocket = IsEquip ? TEXT("equip_sword_l") : TEXT("unequip_sword_l");
 	FName RightWeaponSocket = IsEquip ? TEXT("equip_sword_r") : TEXT("unequip_sword_r");
 
@@ -379,6 +804,8 @@ void AKhopeshCharacter::SetWeapon_Implementation(bool IsEquip)
 
 void AKhopeshCharacter::PlayDie_Implementation()
 {
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshPlayDie);
+
 	Anim->PlayMontage(EMontage::DIE);
 	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -396,20 +823,43 @@ void AKhopeshCharacter::Move(EAxis::Type Axis, float Value)
 	AddMovementInput(Direction, Value);
 }
 
+void AKhopeshCharacter::SetActorYaw(FKhopeshYaw Yaw)
+{
+	FRotator Rotation = GetActorRotation();
+	Rotation.Yaw = Yaw.Get();
+	SetActorRotation(Rotation);
+}
+
+bool AKhopeshCharacter::PlayEffect(ECombatEffect Effect)
+{
+	// Only an effect the profile leaves empty falls back to the blueprint event
+	if (!Profile) return false;
+
+	FKhopeshEffectSettings const& Settings = Profile->GetEffect(Effect);
+	if (Settings.IsEmpty()) return false;
+
+	auto LocalPlayer = Cast<AKhopeshPlayerController>(GetWorld()->GetFirstPlayerController());
+	FKhopeshEffectPool* EffectPool = LocalPlayer ? LocalPlayer->GetEffectPool() : nullptr;
+	if (!EffectPool) return false;
+
+	// An effect still loading is skipped, not doubled by the blueprint one
+	EffectPool->Play(Effect, Settings, GetActorLocation(), GetActorRotation());
+	return true;
+}
+
 void AKhopeshCharacter::Break(AKhopeshCharacter* Target)
 {
-	GetWorldTimerManager().ClearTimer(DefenseTimer);
 	auto Rotator = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), Target->GetActorLocation());
-	EndDefenseMontage(true, Rotator);
-	ShowParryingEffect();
-	Target->PlayBroken();
-	IsDefensing = false;
-	IsStrongMode = true;
 
-	GetWorldTimerManager().SetTimer(BrokenTimer, [this]()
-	{
-		IsStrongMode = false;
-	}, BrokenDuration, false);
+	FKhopeshCombatEvent DefenseEvent;
+	DefenseEvent.Type = ECombatEvent::DEFENSE_SUCCESS;
+	DefenseEvent.Yaw = FKhopeshYaw(Rotator.Yaw);
+	PushCombatEvent(DefenseEvent);
+
+	FKhopeshCombatEvent BrokenEvent;
+	BrokenEvent.Type = ECombatEvent::BROKEN;
+	Target->PushCombatEvent(BrokenEvent);
+	Combat.Break(FKhopeshCombatState::ToFrames(Profile->BrokenDuration));
 }
 
 void AKhopeshCharacter::Die()
@@ -417,62 +867,307 @@ void AKhopeshCharacter::Die()
 	auto MyController = Cast<AKhopeshPlayerController>(GetController());
 	MyController->PlayerDead();
 	PlayDie();
+
+	// Nothing of a dead character changes anymore. The channel closes after sending the death, then costs nothing.
+	SetNetDormancy(DORM_DormantAll);
+
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	if (GameMode)
+	{
+		GameMode->GetProximityGrid().Remove(this);
+	}
 }
 
-bool AKhopeshCharacter::CanDodge() const
+void AKhopeshCharacter::MarkStatusDirty()
 {
-	return (FMath::IsNearlyEqual(NextDodgeTime, 0.0f) || NextDodgeTime <= GetWorld()->GetTimeSeconds());
+	Status.HP = static_cast<uint16>(FMath::CeilToInt(HP * 10.0f));
+	Status.Speed = static_cast<uint16>(FMath::RoundToInt(Speed));
+	Status.IsCombatMode = IsCombatMode;
+	++Status.Revision;
 }
 
-bool AKhopeshCharacter::IsEnemyNear() const
+void AKhopeshCharacter::ApplyHP()
 {
-	return GetWorld()->OverlapAnyTestByObjectType(
-		GetActorLocation(),
-		FQuat::Identity,
-		ECollisionChannel::ECC_GameTraceChannel1,
-		FCollisionShape::MakeSphere(CombatSwapRange),
-		FCollisionQueryParams(NAME_None, false, this)
-	);
+	if (IsLocallyControlled() || !PlayerState) return;
+
+	// Fighters of other matches may be seen too, only the duel opponent is the enemy
+	auto LocalController = Cast<AKhopeshPlayerController>(GetWorld()->GetFirstPlayerController());
+	if (!LocalController || LocalController->GetOpponentState() != PlayerState) return;
+
+	auto LocalCharacter = Cast<AKhopeshCharacter>(LocalController->GetPawn());
+	if (LocalCharacter)
+	{
+		LocalCharacter->OnApplyEnemyHP(HP);
+	}
 }
 
-FRotator AKhopeshCharacter::GetRotationByAim() const
+void AKhopeshCharacter::WakeTick()
 {
-	FRotator NewRotation = GetActorRotation();
-	NewRotation.Yaw = GetControlRotation().Yaw;
-	return NewRotation;
+	if (PrimaryActorTick.TickInterval > 0.0f)
+	{
+		SetActorTickInterval(0.0f);
+	}
 }
 
-FRotator AKhopeshCharacter::GetRotationByInputKey() const
+void AKhopeshCharacter::UpdateTickInterval()
 {
-	float Horizontal = GetInputAxisValue(TEXT("MoveRight"));
-	float Vertical = GetInputAxisValue(TEXT("MoveForward"));
-	FRotator Rotation = GetRotationByAim();
+	// Per frame work is a speed transition on every machine, and on the server pending events, a pending equip
+	// and the rewind record of a moving character. Each of them wakes the tick again when it starts.
+	bool IsActive = GetCharacterMovement()->MaxWalkSpeed != Speed;
 
-	if (Horizontal == 0.0f)
+	if (HasAuthority() && !IsRollbackDuel)
 	{
-		Rotation.Yaw += (Vertical == -1.0f) ? 180.0f : 0.0f;
+		IsActive |= Swing.IsActive() || PendingCombatEvents.Events.Num() > 0 || IsEnemyNear != IsCombatMode || !GetVelocity().IsNearlyZero();
 	}
-	else
+
+	float const TickInterval = IsActive ? 0.0f : Profile->IdleTickInterval;
+	if (PrimaryActorTick.TickInterval != TickInterval)
 	{
-		Rotation.Yaw += (Horizontal * 90.0f) + (Horizontal * Vertical * -45.0f);
+		SetActorTickInterval(TickInterval);
 	}
+}
+
+void AKhopeshCharacter::PushCombatEvent(FKhopeshCombatEvent const& Event)
+{
+	ApplyCombatEvent(Event);
 
-	return Rotation;
+	if (PendingCombatEvents.Events.Num() == FKhopeshCombatEvents::MaxEvents)
+	{
+		FlushCombatEvents();
+	}
+
+	PendingCombatEvents.Events.Add(Event);
+	WakeTick();
 }
 
-EMontage AKhopeshCharacter::GetHitMontageByDir(float Dir) const
+void AKhopeshCharacter::FlushCombatEvents()
 {
-	UE_LOG(LogTemp, Warning, TEXT("After : %f"), Dir);
-	EMontage Montage = (Dir > 0.0f) ? EMontage::HIT_LEFT : EMontage::HIT_RIGHT;
+	if (PendingCombatEvents.Events.Num() == 0) return;
+
+	PlayCombatEvents(PendingCombatEvents);
+	PendingCombatEvents.Events.Reset();
+}
 
-	if (FMath::Abs(Dir) <= 45.0f)
+void AKhopeshCharacter::ApplyCombatEvent(FKhopeshCombatEvent const& Event)
+{
+	// Every event of both modes passes here on the server, so this is where the match telemetry counts them
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	if (GameMode)
+	{
+		GameMode->RecordCombatEvent(GetController(), Event.Type);
+	}
+
+	switch (Event.Type)
+	{
+	case ECombatEvent::HIT:
+	{
+		if (!PlayEffect(ECombatEffect::HIT_SOUND))
+		{
+			OnPlayHitSound();
+		}
+
+		if (IsLocallyControlled() && !PlayEffect(ECombatEffect::HIT))
+		{
+			OnShowHitEffect();
+		}
+
+		// The last hit leaves the montage to PlayDie
+		if (Event.Montage != static_cast<uint8>(EMontage::DIE))
+		{
+			Anim->PlayMontage(static_cast<EMontage>(Event.Montage));
+		}
+		break;
+	}
+	case ECombatEvent::DEFENSE_SUCCESS:
+	{
+		Anim->JumpToSection(EMontage::DEFENSE, DefenseSuccessSection);
+
+		SetActorYaw(Event.Yaw);
+
+		if (IsLocallyControlled() && !PlayEffect(ECombatEffect::PARRYING))
+		{
+			OnShowParryingEffect();
+		}
+		break;
+	}
+	case ECombatEvent::DEFENSE_FAIL:
+		Anim->JumpToSection(EMontage::DEFENSE, DefenseFailSection);
+		break;
+	case ECombatEvent::BROKEN:
+		Anim->PlayMontage(EMontage::BROKEN);
+		Anim->Montage_SetPlayRate(Anim->Get(EMontage::BROKEN), BrokenPlayRate);
+		break;
+	}
+}
+
+void AKhopeshCharacter::OnRep_Status()
+{
+	float const OldHP = HP;
+
+	HP = Status.HP / 10.0f;
+	Speed = Status.Speed;
+	IsCombatMode = Status.IsCombatMode;
+	WakeTick();
+
+	if (HP != OldHP)
 	{
-		Montage = EMontage::HIT_BACK;
+		ApplyHP();
 	}
-	else if (FMath::Abs(Dir) >= 135.0f)
+}
+
+void AKhopeshCharacter::OnRep_Dodge()
+{
+	SetActorYaw(LastDodge.Yaw);
+	Anim->PlayMontage(LastDodge.IsLongDodge ? EMontage::DODGE_LONG : EMontage::DODGE_SHORT);
+}
+
+void AKhopeshCharacter::OnRep_Duel()
+{
+	// Both fighters have to be mapped before the duel can start
+	if (IsRollbackDuel || !Duel.Fighters[0] || !Duel.Fighters[1]) return;
+
+	IsRollbackDuel = true;
+	GetCharacterMovement()->DisableMovement();
+	AppliedDuelState = FKhopeshRollbackSession::MakeStart(Duel).Fighters[Duel.Slot];
+	AppliedDuelState.Montage = FKhopeshFighterState::NoMontage;
+
+	if (HasAuthority())
 	{
-		Montage = EMontage::HIT_FRONT;
+		SetReplicateMovement(false);
+
+		auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+		if (GameMode)
+		{
+			GameMode->GetProximityGrid().Remove(this);
+		}
 	}
+	else if (Role == ROLE_AutonomousProxy)
+	{
+		// The owning client runs the session for both fighters, the controller may not be replicated yet
+		auto MyController = Cast<AKhopeshPlayerController>(GetWorld()->GetFirstPlayerController());
+		if (MyController)
+		{
+			MyController->StartDuel(Duel);
+		}
+	}
+}
+
+bool AKhopeshCharacter::CanDodge() const
+{
+	// Cooldown and falling are checked by the movement component
+	return IsStartCombat && !Anim->IsMontagePlay();
+}
 
-	return Montage;
+void AKhopeshCharacter::StartDodge(FKhopeshYaw Yaw, bool IsLongDodge)
+{
+	SetActorYaw(Yaw);
+	Anim->PlayMontage(IsLongDodge ? EMontage::DODGE_LONG : EMontage::DODGE_SHORT);
+
+	if (HasAuthority())
+	{
+		LastDodge.Count++;
+		LastDodge.IsLongDodge = IsLongDodge;
+		LastDodge.Yaw = Yaw;
+	}
+}
+
+FKhopeshYaw AKhopeshCharacter::GetDodgeYaw(FVector const& InputAcceleration) const
+{
+	// Toward the movement input, or along the aim without input
+	if (InputAcceleration.IsNearlyZero())
+	{
+		return FKhopeshYaw(GetRotationByAim().Yaw);
+	}
+
+	return FKhopeshYaw(InputAcceleration.Rotation().Yaw);
+}
+
+bool AKhopeshCharacter::IsAttackable() const
+{
+	return GetCapsuleComponent()->GetCollisionEnabled() != ECollisionEnabled::NoCollision;
+}
+
+bool AKhopeshCharacter::GetRewoundTransform(float Time, FVector& OutLocation, FRotator& OutRotation) const
+{
+	if (RewindBuffer.Sample(Time, OutLocation, OutRotation)) return true;
+
+	OutLocation = GetActorLocation();
+	OutRotation = GetActorRotation();
+	return false;
+}
+
+bool AKhopeshCharacter::HasBladeSockets() const
+{
+	return LeftWeapon->DoesSocketExist(Profile->BladeTipSocket) || RightWeapon->DoesSocketExist(Profile->BladeTipSocket);
+}
+
+FKhopeshBladeSample AKhopeshCharacter::GetBladeSample() const
+{
+	FKhopeshBladeSample Sample;
+	Sample.Time = GetWorld()->GetTimeSeconds();
+
+	UStaticMeshComponent const* Weapons[2] = { LeftWeapon, RightWeapon };
+
+	for (int32 Blade = 0; Blade < 2; ++Blade)
+	{
+		if (Weapons[Blade]->DoesSocketExist(Profile->BladeTipSocket))
+		{
+			Sample.Base[Blade] = Weapons[Blade]->GetSocketLocation(Profile->BladeBaseSocket);
+			Sample.Tip[Blade] = Weapons[Blade]->GetSocketLocation(Profile->BladeTipSocket);
+		}
+		else
+		{
+			Sample.Base[Blade] = GetActorLocation();
+			Sample.Tip[Blade] = Sample.Base[Blade] + GetActorForwardVector() * Profile->AttackRange;
+		}
+	}
+
+	return Sample;
+}
+
+void AKhopeshCharacter::ResolveSwing()
+{
+	// Only the opponent of the same match can be hit, a fighter of a neighbouring arena never is
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	AKhopeshPlayerController* Opponent = GameMode ? GameMode->GetOpponent(GetController()) : nullptr;
+	auto Other = Opponent ? Cast<AKhopeshCharacter>(Opponent->GetPawn()) : nullptr;
+
+	if (Other && Other->IsAttackable())
+	{
+		auto Capsule = Other->GetCapsuleComponent();
+		FVector const HalfAxis = FVector::UpVector * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+		float const HitRadius = Profile->AttackRadius + Capsule->GetScaledCapsuleRadius();
+
+		for (FKhopeshBladeSegment const& Segment : Swing.GetPendingSegments())
+		{
+			// Each sample is tested against the opponent as the attacker saw it at its time
+			FVector Location;
+			FRotator Rotation;
+			Other->GetRewoundTransform(Segment.Time - AttackRewindDelay, Location, Rotation);
+
+			// Blade against capsule is a segment to segment distance test
+			FVector BladePoint, CapsulePoint;
+			FMath::SegmentDistToSegmentSafe(Segment.Base, Segment.Tip, Location - HalfAxis, Location + HalfAxis, BladePoint, CapsulePoint);
+			if (FVector::DistSquared(BladePoint, CapsulePoint) > FMath::Square(HitRadius)) continue;
+
+			if (Swing.TryAddHit(Other))
+			{
+				Other->TakeDamage(Swing.GetDamage(), FDamageEvent(), GetController(), this);
+			}
+		}
+	}
+
+	Swing.ClearPending();
+}
+
+float AKhopeshCharacter::GetAttackRewindTime() const
+{
+	return GetWorld()->GetTimeSeconds() - AttackRewindDelay;
+}
+
+FRotator AKhopeshCharacter::GetRotationByAim() const
+{
+	FRotator NewRotation = GetActorRotation();
+	NewRotation.Yaw = GetControlRotation().Yaw;
+	return NewRotation;
 }
\ No newline at end of file
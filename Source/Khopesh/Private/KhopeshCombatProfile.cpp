@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshCombatProfile.h"
+#include "KhopeshRules.h"
+#include "Khopesh.h"
+
+FName const UKhopeshCombatProfile::CombatBundle(TEXT("Combat"));
+FName const UKhopeshCombatProfile::EffectBundle(TEXT("Effect"));
+
+UKhopeshCombatProfile::UKhopeshCombatProfile()
+{
+	MaxCombo = 1;
+	SwingDuration = 0.1f;
+	TraceSubstepRate = 120.0f;
+	BladeBaseSocket = TEXT("blade_base");
+	BladeTipSocket = TEXT("blade_tip");
+	MaxRewindTime = 0.25f;
+	RewindBufferSize = 64;
+	IdleTickInterval = 0.25f;
+
+	// Feedback on the player's own hits and parries goes before the rest
+	HitEffect.Priority = 1;
+	ParryingEffect.Priority = 2;
+	HitSound.MaxInstances = 2;
+}
+
+FPrimaryAssetId UKhopeshCombatProfile::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(GetAssetType(), GetFName());
+}
+
+void UKhopeshCombatProfile::PostLoad()
+{
+	Super::PostLoad();
+	BuildTables();
+}
+
+#if WITH_EDITOR
+void UKhopeshCombatProfile::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BuildTables();
+}
+#endif
+
+void UKhopeshCombatProfile::GetStats(FKhopeshStats& OutStats) const
+{
+	OutStats.WeakAttackDamage = WeakAttackDamage;
+	OutStats.StrongAttackDamage = StrongAttackDamage;
+	OutStats.WeakAttackHitNum = WeakAttackHitNum;
+	OutStats.StrongAttackHitNum = StrongAttackHitNum;
+	OutStats.MaxCombo = MaxCombo;
+}
+
+FKhopeshEffectSettings const& UKhopeshCombatProfile::GetEffect(ECombatEffect Effect) const
+{
+	switch (Effect)
+	{
+	case ECombatEffect::HIT:
+		return HitEffect;
+	case ECombatEffect::PARRYING:
+		return ParryingEffect;
+	case ECombatEffect::HIT_SOUND:
+		return HitSound;
+	default:
+		return CombatEffect;
+	}
+}
+
+void UKhopeshCombatProfile::BuildTables()
+{
+	MontageTable.SetNumZeroed(static_cast<int32>(EMontage::DIE) + 1);
+	MontageTable[static_cast<int32>(EMontage::ATTACK_WEAK)] = AttackWeak.Get();
+	MontageTable[static_cast<int32>(EMontage::ATTACK_STRONG)] = AttackStrong.Get();
+	MontageTable[static_cast<int32>(EMontage::DEFENSE)] = Defense.Get();
+	MontageTable[static_cast<int32>(EMontage::DODGE_SHORT)] = DodgeShort.Get();
+	MontageTable[static_cast<int32>(EMontage::DODGE_LONG)] = DodgeLong.Get();
+	MontageTable[static_cast<int32>(EMontage::HIT_FRONT)] = HitFront.Get();
+	MontageTable[static_cast<int32>(EMontage::HIT_LEFT)] = HitLeft.Get();
+	MontageTable[static_cast<int32>(EMontage::HIT_BACK)] = HitBack.Get();
+	MontageTable[static_cast<int32>(EMontage::HIT_RIGHT)] = HitRight.Get();
+	MontageTable[static_cast<int32>(EMontage::BROKEN)] = Broken.Get();
+	MontageTable[static_cast<int32>(EMontage::EQUIP)] = Equip.Get();
+	MontageTable[static_cast<int32>(EMontage::UNEQUIP)] = Unequip.Get();
+	MontageTable[static_cast<int32>(EMontage::DIE)] = Die.Get();
+
+	// Sections are named Attack_1 ~ Attack_MaxCombo, index 0 only keeps the combo as the index
+	ComboSections.Reset(MaxCombo + 1);
+	for (int32 Combo = 0; Combo <= MaxCombo; ++Combo)
+	{
+		ComboSections.Emplace(TEXT("Attack"), NAME_EXTERNAL_TO_INTERNAL(Combo));
+	}
+}
+
+void UKhopeshCombatProfile::LoadMontages()
+{
+	if (MontageTable.Num() > 0 && MontageTable[static_cast<int32>(EMontage::DIE)]) return;
+
+	UE_LOG(LogKhopesh, Warning, TEXT("%s was not preloaded, loading its montages synchronously"), *GetName());
+
+	TSoftObjectPtr<UAnimMontage> const Montages[] = { AttackWeak, AttackStrong, Defense, DodgeShort, DodgeLong,
+		HitFront, HitLeft, HitBack, HitRight, Broken, Equip, Unequip, Die };
+
+	for (TSoftObjectPtr<UAnimMontage> const& Montage : Montages)
+	{
+		Montage.LoadSynchronous();
+	}
+
+	BuildTables();
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshCombatState.h"
+#include "KhopeshRules.h"
+
+FKhopeshCombatState::FKhopeshCombatState()
+	: Combo(0), ComboFrames(0), DefenseFrames(0), BrokenFrames(0), IsDefensing(false), IsStrongMode(false)
+{
+}
+
+uint8 FKhopeshCombatState::Step()
+{
+	if (IsIdle()) return 0;
+
+	uint8 Closed = 0;
+
+	if (ComboFrames > 0 && --ComboFrames == 0)
+	{
+		Combo = 0;
+		Closed |= ECombatWindow::COMBO;
+	}
+
+	if (DefenseFrames > 0 && --DefenseFrames == 0)
+	{
+		IsDefensing = false;
+		Closed |= ECombatWindow::DEFENSE;
+	}
+
+	if (BrokenFrames > 0 && --BrokenFrames == 0)
+	{
+		IsStrongMode = false;
+		Closed |= ECombatWindow::BROKEN;
+	}
+
+	return Closed;
+}
+
+uint8 FKhopeshCombatState::StartAttack(uint8 MaxCombo)
+{
+	Combo = FKhopeshRules::GetNextCombo(Combo, MaxCombo);
+	ComboFrames = 0;
+	IsStrongMode = false;
+	return Combo;
+}
+
+void FKhopeshCombatState::StartComboWindow(uint16 Frames)
+{
+	ComboFrames = Frames;
+}
+
+void FKhopeshCombatState::ResetCombo()
+{
+	Combo = 0;
+	ComboFrames = 0;
+}
+
+void FKhopeshCombatState::StartDefense(uint16 Frames)
+{
+	IsDefensing = true;
+	DefenseFrames = Frames;
+}
+
+void FKhopeshCombatState::Break(uint16 Frames)
+{
+	// A successful parry closes the defense window and opens the strong attack window
+	IsDefensing = false;
+	DefenseFrames = 0;
+	IsStrongMode = true;
+	BrokenFrames = Frames;
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshEffectPool.h"
+#include "Khopesh.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Sound/SoundBase.h"
+#include "Components/AudioComponent.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Play Effect"), STAT_KhopeshPlayEffect, STATGROUP_Khopesh);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Reused"), STAT_KhopeshEffectsReused, STATGROUP_Khopesh);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Created"), STAT_KhopeshEffectsCreated, STATGROUP_Khopesh);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Stolen"), STAT_KhopeshEffectsStolen, STATGROUP_Khopesh);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Dropped"), STAT_KhopeshEffectsDropped, STATGROUP_Khopesh);
+
+static TAutoConsoleVariable<int32> CVarMaxEffects(
+	TEXT("khopesh.MaxEffects"), 24,
+	TEXT("Combat effects playing at once. Past it a new effect takes over an older one of a lower or equal priority."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarEffectCreatesPerFrame(
+	TEXT("khopesh.EffectCreatesPerFrame"), 2,
+	TEXT("Effect instances the pool may create in one frame. Past it a playing effect is taken over, or the new one dropped."),
+	ECVF_Scalability);
+
+FKhopeshEffectPool::FKhopeshEffectPool(UWorld* InWorld)
+{
+	World = InWorld;
+	CreateFrame = 0;
+	FrameCreates = 0;
+	Requests = 0;
+	Reused = 0;
+	Created = 0;
+	Stolen = 0;
+	Dropped = 0;
+}
+
+FKhopeshEffectPool::~FKhopeshEffectPool()
+{
+	if (Requests > 0)
+	{
+		UE_LOG(LogKhopesh, Log, TEXT("Effect pool : %d requests, %.1f%% served by the pool, %d created, %d stolen, %d dropped"),
+			Requests, (Reused + Stolen) * 100.0f / Requests, Created, Stolen, Dropped);
+	}
+
+	for (FInstance const& Instance : Instances)
+	{
+		if (Instance.Particle && !Instance.Particle->IsPendingKill())
+		{
+			Instance.Particle->DestroyComponent();
+		}
+
+		if (Instance.Sound && !Instance.Sound->IsPendingKill())
+		{
+			Instance.Sound->DestroyComponent();
+		}
+	}
+}
+
+void FKhopeshEffectPool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (FInstance& Instance : Instances)
+	{
+		Collector.AddReferencedObject(Instance.Particle);
+		Collector.AddReferencedObject(Instance.Sound);
+	}
+}
+
+bool FKhopeshEffectPool::Play(ECombatEffect Effect, FKhopeshEffectSettings const& Settings, FVector const& Location, FRotator const& Rotation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshPlayEffect);
+
+	UParticleSystem* ParticleTemplate = Settings.Particle.Get();
+	USoundBase* Sound = Settings.Sound.Get();
+	if (!World.IsValid() || (!ParticleTemplate && !Sound)) return false;
+
+	++Requests;
+
+	int32 const Index = Acquire(Effect, Settings);
+	if (Index == INDEX_NONE)
+	{
+		++Dropped;
+		INC_DWORD_STAT(STAT_KhopeshEffectsDropped);
+		return true;
+	}
+
+	FInstance& Instance = Instances[Index];
+	Instance.Effect = Effect;
+	Instance.Priority = Settings.Priority;
+	Instance.StartTime = World->GetTimeSeconds();
+
+	// Same outer as UGameplayStatics spawns, so the components render without an owning actor
+	UObject* const Outer = World->GetWorldSettings();
+
+	if (ParticleTemplate)
+	{
+		if (!Instance.Particle)
+		{
+			Instance.Particle = NewObject<UParticleSystemComponent>(Outer);
+			Instance.Particle->bAutoActivate = false;
+			Instance.Particle->bAutoDestroy = false;
+			Instance.Particle->RegisterComponentWithWorld(World.Get());
+		}
+
+		if (Instance.Particle->Template != ParticleTemplate)
+		{
+			Instance.Particle->SetTemplate(ParticleTemplate);
+		}
+
+		Instance.Particle->SetWorldLocationAndRotation(Location, Rotation);
+		Instance.Particle->Activate(true);
+	}
+	else if (Instance.Particle)
+	{
+		Instance.Particle->Deactivate();
+	}
+
+	if (Sound)
+	{
+		if (!Instance.Sound)
+		{
+			Instance.Sound = NewObject<UAudioComponent>(Outer);
+			Instance.Sound->bAutoActivate = false;
+			Instance.Sound->bAutoDestroy = false;
+			Instance.Sound->RegisterComponentWithWorld(World.Get());
+		}
+
+		Instance.Sound->SetSound(Sound);
+		Instance.Sound->SetWorldLocation(Location);
+		Instance.Sound->Play();
+	}
+	else if (Instance.Sound)
+	{
+		Instance.Sound->Stop();
+	}
+
+	return true;
+}
+
+int32 FKhopeshEffectPool::Acquire(ECombatEffect Effect, FKhopeshEffectSettings const& Settings)
+{
+	int32 IdleIndex = INDEX_NONE;
+	int32 NumPlaying = 0;
+	int32 NumEffectPlaying = 0;
+
+	for (int32 Index = 0; Index < Instances.Num(); ++Index)
+	{
+		FInstance const& Instance = Instances[Index];
+		if (IsPlaying(Instance))
+		{
+			++NumPlaying;
+			NumEffectPlaying += Instance.Effect == Effect;
+		}
+		else if (IdleIndex == INDEX_NONE || (Instance.Effect == Effect && Instances[IdleIndex].Effect != Effect))
+		{
+			// An idle instance of the same effect already has its template
+			IdleIndex = Index;
+		}
+	}
+
+	int32 Victim = INDEX_NONE;
+	if (NumEffectPlaying >= FMath::Max(Settings.MaxInstances, 1))
+	{
+		Victim = FindVictim(MAX_int32, [Effect](FInstance const& Instance) { return Instance.Effect == Effect; });
+	}
+	else if (NumPlaying >= CVarMaxEffects.GetValueOnGameThread())
+	{
+		Victim = FindVictim(Settings.Priority, [](FInstance const&) { return true; });
+		if (Victim == INDEX_NONE) return INDEX_NONE;
+	}
+	else if (IdleIndex != INDEX_NONE)
+	{
+		++Reused;
+		INC_DWORD_STAT(STAT_KhopeshEffectsReused);
+		return IdleIndex;
+	}
+	else
+	{
+		if (CreateFrame != GFrameCounter)
+		{
+			CreateFrame = GFrameCounter;
+			FrameCreates = 0;
+		}
+
+		if (FrameCreates < CVarEffectCreatesPerFrame.GetValueOnGameThread())
+		{
+			++FrameCreates;
+			++Created;
+			INC_DWORD_STAT(STAT_KhopeshEffectsCreated);
+			CSV_CUSTOM_STAT(Khopesh, EffectsCreated, 1, ECsvCustomStatOp::Accumulate);
+
+			return Instances.AddZeroed();
+		}
+
+		// Out of creations for this frame
+		Victim = FindVictim(Settings.Priority, [](FInstance const&) { return true; });
+		if (Victim == INDEX_NONE) return INDEX_NONE;
+	}
+
+	++Stolen;
+	INC_DWORD_STAT(STAT_KhopeshEffectsStolen);
+	return Victim;
+}
+
+int32 FKhopeshEffectPool::FindVictim(int32 Priority, TFunctionRef<bool(FInstance const&)> Predicate) const
+{
+	// Lowest priority first, then the oldest
+	int32 Victim = INDEX_NONE;
+
+	for (int32 Index = 0; Index < Instances.Num(); ++Index)
+	{
+		FInstance const& Instance = Instances[Index];
+		if (Instance.Priority > Priority || !IsPlaying(Instance) || !Predicate(Instance)) continue;
+
+		if (Victim == INDEX_NONE || Instance.Priority < Instances[Victim].Priority
+			|| (Instance.Priority == Instances[Victim].Priority && Instance.StartTime < Instances[Victim].StartTime))
+		{
+			Victim = Index;
+		}
+	}
+
+	return Victim;
+}
+
+bool FKhopeshEffectPool::IsPlaying(FInstance const& Instance) const
+{
+	return (Instance.Particle && Instance.Particle->IsActive()) || (Instance.Sound && Instance.Sound->IsPlaying());
+}
\ No newline at end of file
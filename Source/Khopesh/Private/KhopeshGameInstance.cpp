@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshGameInstance.h"
+#include "Khopesh.h"
+#include "KhopeshCombatProfile.h"
+#include "Engine/AssetManager.h"
+#include "Misc/CoreDelegates.h"
+
+void UKhopeshGameInstance::Init()
+{
+	Super::Init();
+
+	IsPreloaded = false;
+	PreloadStartTime = FPlatformTime::Seconds();
+	MapLoadStartTime = PreloadStartTime;
+	MapLoadedTime = 0.0;
+
+	FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UKhopeshGameInstance::OnPreLoadMap);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UKhopeshGameInstance::OnPostLoadMap);
+
+	// The asset manager keeps the profiles and their bundles loaded across every map change. A dedicated server
+	// plays no effect.
+	TArray<FName> Bundles = { UKhopeshCombatProfile::CombatBundle };
+	if (!IsRunningDedicatedServer())
+	{
+		Bundles.Add(UKhopeshCombatProfile::EffectBundle);
+	}
+
+	PreloadHandle = UAssetManager::Get().LoadPrimaryAssetsWithType(UKhopeshCombatProfile::GetAssetType(), Bundles,
+		FStreamableDelegate::CreateUObject(this, &UKhopeshGameInstance::OnCombatPreloaded));
+
+	// Nothing to load, or everything was already in memory
+	if (!PreloadHandle || PreloadHandle->HasLoadCompleted())
+	{
+		OnCombatPreloaded();
+	}
+}
+
+void UKhopeshGameInstance::Shutdown()
+{
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+
+	Super::Shutdown();
+}
+
+void UKhopeshGameInstance::CallWhenCombatPreloaded(FSimpleDelegate const& Callback)
+{
+	if (IsPreloaded)
+	{
+		Callback.ExecuteIfBound();
+	}
+	else
+	{
+		PreloadCallbacks.Add(Callback);
+	}
+}
+
+void UKhopeshGameInstance::OnCombatPreloaded()
+{
+	if (IsPreloaded) return;
+	IsPreloaded = true;
+
+	TArray<UObject*> Profiles;
+	UAssetManager::Get().GetPrimaryAssetObjectList(UKhopeshCombatProfile::GetAssetType(), Profiles);
+
+	for (UObject* Profile : Profiles)
+	{
+		CastChecked<UKhopeshCombatProfile>(Profile)->BuildTables();
+	}
+
+	UE_LOG(LogKhopesh, Log, TEXT("Preloaded %d combat profiles in %.1f ms"), Profiles.Num(), (FPlatformTime::Seconds() - PreloadStartTime) * 1000.0);
+
+	for (FSimpleDelegate const& Callback : PreloadCallbacks)
+	{
+		Callback.ExecuteIfBound();
+	}
+
+	PreloadCallbacks.Empty();
+}
+
+void UKhopeshGameInstance::OnPreLoadMap(FString const& MapName)
+{
+	MapLoadStartTime = FPlatformTime::Seconds();
+}
+
+void UKhopeshGameInstance::OnPostLoadMap(UWorld* World)
+{
+	MapLoadedTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogKhopesh, Log, TEXT("Map %s loaded in %.1f ms"), World ? *World->GetMapName() : TEXT("None"),
+		(MapLoadedTime - MapLoadStartTime) * 1000.0);
+
+	if (!EndFrameHandle.IsValid())
+	{
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &UKhopeshGameInstance::OnEndFrame);
+	}
+}
+
+void UKhopeshGameInstance::OnEndFrame()
+{
+	double const Now = FPlatformTime::Seconds();
+
+	UE_LOG(LogKhopesh, Log, TEXT("First frame %.1f ms after the map load, %.1f ms after it started"),
+		(Now - MapLoadedTime) * 1000.0, (Now - MapLoadStartTime) * 1000.0);
+	CSV_EVENT(Khopesh, TEXT("FirstFrame %.1f"), (Now - MapLoadStartTime) * 1000.0);
+
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	EndFrameHandle.Reset();
+}
\ No newline at end of file
@@ -1,17 +1,118 @@
 ﻿// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "KhopeshGameMode.h"
+#include "Khopesh.h"
 #include "TimerManager.h"
 #include "Engine/World.h"
 #include "KhopeshCharacter.h"
 #include "Kismet/GameplayStatics.h"
 #include "KhopeshPlayerController.h"
+#include "KhopeshReplicationGraph.h"
+#include "KhopeshGameInstance.h"
 #include "GameFramework/PlayerStart.h"
 #include "UObject/ConstructorHelpers.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Engine/NetDriver.h"
+
+DECLARE_CYCLE_STAT(TEXT("GameMode Tick"), STAT_KhopeshGameModeTick, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Step Combat"), STAT_KhopeshStepCombat, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("Advance Duel"), STAT_KhopeshAdvanceDuel, STATGROUP_Khopesh);
+
+void FKhopeshMatchTelemetry::Reset(float Time)
+{
+	FrameTimes.Reset();
+	StartTime = Time;
+	Hits = 0;
+	Parries = 0;
+}
+
+AKhopeshGameMode::AKhopeshGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	ProximityCellSize = 1000.0f;
+	IsRollbackMode = false;
+	CombatTime = 0.0f;
+	FinishedMatches = 0;
+}
+
+void AKhopeshGameMode::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	ProximityGrid.Init(ProximityCellSize);
+}
 
 void AKhopeshGameMode::BeginPlay()
 {
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), APlayerStart::StaticClass(), Spawns);
+	Super::BeginPlay();
+
+	if (Matches.Num() == 0)
+	{
+		InitMatches();
+	}
+
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		LoadRecorder.OpenFromCommandLine();
+		FParse::Value(FCommandLine::Get(), TEXT("KhopeshPoolState="), PoolStatePath);
+	}
+
+	// Players that were ready before the server spawn once it is
+	if (auto GameInstance = GetGameInstance<UKhopeshGameInstance>())
+	{
+		GameInstance->CallWhenCombatPreloaded(FSimpleDelegate::CreateWeakLambda(this, [this]()
+		{
+			for (AKhopeshPlayerController* Player : Players)
+			{
+				RestartWhenReady(Player);
+			}
+
+			WritePoolState();
+		}));
+	}
+	else
+	{
+		WritePoolState();
+	}
+}
+
+void AKhopeshGameMode::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshGameModeTick);
+	CSV_SCOPED_TIMING_STAT(Khopesh, GameModeTick);
+
+	Super::Tick(DeltaSeconds);
+	ProximityGrid.Update();
+
+	// Combat windows advance at a fixed rate, whatever the server frame rate is
+	CombatTime += DeltaSeconds;
+	while (CombatTime >= FKhopeshCombatState::FrameTime)
+	{
+		CombatTime -= FKhopeshCombatState::FrameTime;
+		StepCombat();
+	}
+
+	float const FrameTime = FKhopeshLoadRecorder::GetFrameWorkTime() * 1000.0f;
+
+	int32 NumDuels = 0;
+	for (FKhopeshMatch& Match : Matches)
+	{
+		if (Match.DuelSession)
+		{
+			AdvanceDuel(Match);
+		}
+
+		if (!Match.IsFinished && Match.Players.Num() == 2)
+		{
+			Match.Telemetry.FrameTimes.Add(FrameTime);
+			++NumDuels;
+		}
+	}
+
+	CSV_CUSTOM_STAT(Khopesh, Duels, NumDuels, ECsvCustomStatOp::Set);
+
+	LoadRecorder.Tick(GetWorld(), DeltaSeconds, Players.Num(), NumDuels);
 }
 
 void AKhopeshGameMode::PostLogin(APlayerController* NewPlayer)
@@ -23,6 +124,8 @@ void AKhopeshGameMode::PostLogin(APlayerController* NewPlayer)
 	if (Controller)
 	{
 		Players.Add(Controller);
+		JoinMatch(Controller);
+		WritePoolState();
 	}
 }
 
@@ -35,38 +138,519 @@ void AKhopeshGameMode::Logout(AController* Exiting)
 	if (Controller)
 	{
 		Players.Remove(Controller);
-		Spawns.Add(TakenSpawns[Controller]);
-		TakenSpawns.Remove(Controller);
+		LeaveMatch(Controller);
+		WritePoolState();
+	}
+}
+
+bool AKhopeshGameMode::PlayerCanRestart_Implementation(APlayerController* Player)
+{
+	// Both sides need the combat montages before a pawn exists, see UKhopeshGameInstance
+	auto GameInstance = GetGameInstance<UKhopeshGameInstance>();
+	if (GameInstance && !GameInstance->IsCombatPreloaded()) return false;
+
+	auto Controller = Cast<AKhopeshPlayerController>(Player);
+	if (Controller && !Controller->IsCombatReady()) return false;
+
+	return Super::PlayerCanRestart_Implementation(Player);
+}
+
+void AKhopeshGameMode::RestartWhenReady(APlayerController* Player)
+{
+	if (Player && !Player->GetPawn() && PlayerCanRestart(Player))
+	{
+		RestartPlayer(Player);
+	}
+}
+
+void AKhopeshGameMode::RequestRematch(AKhopeshPlayerController* Player)
+{
+	int32 const MatchIndex = GetMatchIndex(Player);
+	if (MatchIndex == INDEX_NONE || !Matches[MatchIndex].IsFinished) return;
+
+	FKhopeshMatch& Match = Matches[MatchIndex];
+
+	// Alone after the opponent left, so a rematch means another opponent
+	if (Match.Players.Num() < 2)
+	{
+		RequestNextMatch(Player);
+		return;
+	}
+
+	if (Match.RematchPlayers.Num() == 0)
+	{
+		Match.RematchRequestTime = FPlatformTime::Seconds();
+	}
+
+	Match.RematchPlayers.AddUnique(Player);
+	if (Match.RematchPlayers.Num() < Match.Players.Num()) return;
+
+	// Same arena, same connections, loaded map and montages, only new pawns
+	ResetMatch(Match);
+
+	for (AKhopeshPlayerController* MatchPlayer : Match.Players)
+	{
+		DestroyPawn(MatchPlayer);
+		MatchPlayer->StartRematch();
+	}
+
+	BeginMatch(Match);
+
+	for (AKhopeshPlayerController* MatchPlayer : Match.Players)
+	{
+		RestartWhenReady(MatchPlayer);
 	}
+
+	WritePoolState();
+
+	UE_LOG(LogKhopesh, Log, TEXT("Rematch in %s ready on the server %.1f ms after the first request"),
+		*Match.Arena.ToString(), (FPlatformTime::Seconds() - Match.RematchRequestTime) * 1000.0);
+}
+
+void AKhopeshGameMode::RequestNextMatch(AKhopeshPlayerController* Player)
+{
+	int32 const MatchIndex = GetMatchIndex(Player);
+	if (MatchIndex != INDEX_NONE && !Matches[MatchIndex].IsFinished) return;
+
+	LeaveMatch(Player);
+	DestroyPawn(Player);
+	Player->StartRematch();
+
+	JoinMatch(Player);
+	RestartWhenReady(Player);
 }
 
 void AKhopeshGameMode::PlayerDead(AKhopeshPlayerController* DeadPlayer)
 {
-	check(Players.Num() == 2)
+	FKhopeshMatch& Match = Matches[PlayerMatches.FindChecked(DeadPlayer)];
+	check(Match.Players.Num() == 2)
 	
-	AKhopeshPlayerController* WinPlayer = Players[!Players.Find(DeadPlayer)];
+	AKhopeshPlayerController* WinPlayer = Match.Players[!Match.Players.Find(DeadPlayer)];
 	AKhopeshPlayerController* LosePlayer = DeadPlayer;
 
 	WinPlayer->BlockInput();
 	LosePlayer->BlockInput();
+	Match.IsFinished = true;
 
-	FTimerHandle Timer;
-	GetWorldTimerManager().SetTimer(Timer, [this, WinPlayer, LosePlayer]()
+	// Either player may log out before the result is shown
+	TWeakObjectPtr<AKhopeshPlayerController> WeakWinPlayer = WinPlayer;
+	TWeakObjectPtr<AKhopeshPlayerController> WeakLosePlayer = LosePlayer;
+	GetWorldTimerManager().SetTimer(Match.ResultTimer, [this, WeakWinPlayer, WeakLosePlayer]()
 	{
-		ShowResult(WinPlayer, LosePlayer);
+		ShowResult(WeakWinPlayer.Get(), WeakLosePlayer.Get());
 	}, ShowResultDelay, false);
 }
 
+int32 AKhopeshGameMode::GetMatchIndex(AController const* Player) const
+{
+	auto MatchIndex = PlayerMatches.Find(Cast<AKhopeshPlayerController>(Player));
+	return MatchIndex ? *MatchIndex : INDEX_NONE;
+}
+
+AKhopeshPlayerController* AKhopeshGameMode::GetOpponent(AController const* Player) const
+{
+	int32 const MatchIndex = GetMatchIndex(Player);
+	if (MatchIndex == INDEX_NONE) return nullptr;
+
+	for (AKhopeshPlayerController* Other : Matches[MatchIndex].Players)
+	{
+		if (Other != Player)
+		{
+			return Other;
+		}
+	}
+
+	return nullptr;
+}
+
+void AKhopeshGameMode::RecordCombatEvent(AController* Player, ECombatEvent Type)
+{
+	int32 const MatchIndex = GetMatchIndex(Player);
+	if (MatchIndex == INDEX_NONE) return;
+
+	FKhopeshMatchTelemetry& Telemetry = Matches[MatchIndex].Telemetry;
+	if (Type == ECombatEvent::HIT)
+	{
+		++Telemetry.Hits;
+	}
+	else if (Type == ECombatEvent::DEFENSE_SUCCESS)
+	{
+		++Telemetry.Parries;
+	}
+}
+
+void AKhopeshGameMode::StartDuel(AController* Player)
+{
+	int32 const MatchIndex = GetMatchIndex(Player);
+	if (!IsRollbackMode || MatchIndex == INDEX_NONE) return;
+
+	FKhopeshMatch& Match = Matches[MatchIndex];
+	if (Match.DuelSession || Match.Players.Num() != 2) return;
+
+	AKhopeshCharacter* Fighters[2];
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		Fighters[Slot] = Cast<AKhopeshCharacter>(Match.Players[Slot]->GetPawn());
+		if (!Fighters[Slot] || !Fighters[Slot]->GetCombatProfile()) return;
+	}
+
+	// Quantized here as on the wire, so that every peer starts from the same snapshot
+	FKhopeshDuel Duel;
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		Duel.Fighters[Slot] = Fighters[Slot];
+		Duel.Locations[Slot] = Fighters[Slot]->GetActorLocation().GridSnap(1.0f);
+		Duel.Yaws[Slot] = FKhopeshYaw(Fighters[Slot]->GetActorRotation().Yaw);
+	}
+
+	FKhopeshDuelRules Rules;
+	Fighters[0]->GetDuelRules(Rules);
+	Duel.HP = Fighters[0]->GetHP();
+
+	Match.DuelSession = MakeShared<FKhopeshRollbackSession>(Rules, FKhopeshRollbackSession::MakeStart(Duel), INDEX_NONE);
+
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		Duel.Slot = Slot;
+		Fighters[Slot]->StartDuel(Duel);
+	}
+}
+
+void AKhopeshGameMode::ReceiveDuelInputs(AKhopeshPlayerController* Player, FKhopeshDuelInputs const& Inputs)
+{
+	int32 const MatchIndex = GetMatchIndex(Player);
+	if (MatchIndex == INDEX_NONE) return;
+
+	FKhopeshMatch& Match = Matches[MatchIndex];
+	if (!Match.DuelSession) return;
+
+	// Relay to the opponent as they are, the redundancy already covers its losses
+	int32 const Slot = Match.Players.Find(Player);
+	Match.DuelSession->AddRemoteInputs(Slot, Inputs);
+	Match.Players[1 - Slot]->ReceiveDuelInputs(Inputs);
+}
+
 AActor* AKhopeshGameMode::GetPlayerStart(AController* Player)
 {
-	auto PlayerStart = Spawns[0];
-	TakenSpawns.Add(Cast<AKhopeshPlayerController>(Player), PlayerStart);
-	Spawns.RemoveAt(0);
+	auto Controller = Cast<AKhopeshPlayerController>(Player);
+	auto MatchIndex = PlayerMatches.Find(Controller);
+	if (!MatchIndex) return nullptr;
+
+	FKhopeshMatch& Match = Matches[*MatchIndex];
+	if (Match.Spawns.Num() == 0)
+	{
+		UE_LOG(LogGameMode, Warning, TEXT("No free spawn in %s for %s"), *Match.Arena.ToString(), *Controller->GetName());
+		return nullptr;
+	}
+
+	auto PlayerStart = Match.Spawns[0];
+	Match.TakenSpawns.Add(Controller, PlayerStart);
+	Match.Spawns.RemoveAt(0);
 	return PlayerStart;
 }
 
+void AKhopeshGameMode::JoinMatch(AKhopeshPlayerController* Controller)
+{
+	if (Matches.Num() == 0)
+	{
+		InitMatches();
+	}
+
+	// Fill a waiting match first, then open an empty arena
+	int32 MatchIndex = Matches.IndexOfByPredicate([this](FKhopeshMatch const& Match)
+	{
+		return !Match.IsFinished && Match.Players.Num() == 1;
+	});
+
+	if (MatchIndex == INDEX_NONE)
+	{
+		MatchIndex = Matches.IndexOfByPredicate([](FKhopeshMatch const& Match)
+		{
+			return Match.Players.Num() == 0;
+		});
+	}
+
+	if (MatchIndex == INDEX_NONE)
+	{
+		UE_LOG(LogGameMode, Warning, TEXT("No free arena for %s"), *Controller->GetName());
+		return;
+	}
+
+	Matches[MatchIndex].Players.Add(Controller);
+	PlayerMatches.Add(Controller, MatchIndex);
+
+	if (Matches[MatchIndex].Players.Num() == 2)
+	{
+		BeginMatch(Matches[MatchIndex]);
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+bool AKhopeshGameMode::BeginTestMatch(AKhopeshPlayerController* First, AKhopeshPlayerController* Second)
+{
+	if (Matches.Num() == 0)
+	{
+		InitMatches();
+	}
+
+	int32 const MatchIndex = Matches.IndexOfByPredicate([](FKhopeshMatch const& Match)
+	{
+		return Match.Players.Num() == 0;
+	});
+
+	if (MatchIndex == INDEX_NONE) return false;
+
+	for (AKhopeshPlayerController* Player : { First, Second })
+	{
+		Matches[MatchIndex].Players.Add(Player);
+		PlayerMatches.Add(Player, MatchIndex);
+	}
+
+	BeginMatch(Matches[MatchIndex]);
+	return true;
+}
+#endif
+
+void AKhopeshGameMode::LeaveMatch(AKhopeshPlayerController* Controller)
+{
+	int32 MatchIndex;
+	if (!PlayerMatches.RemoveAndCopyValue(Controller, MatchIndex)) return;
+
+	FKhopeshMatch& Match = Matches[MatchIndex];
+	Match.Players.Remove(Controller);
+	Match.RematchPlayers.Remove(Controller);
+	Match.DuelSession.Reset();
+
+	for (AKhopeshPlayerController* Player : Match.Players)
+	{
+		SetDuelOpponent(Player, nullptr);
+	}
+
+	AActor* Spawn;
+	if (Match.TakenSpawns.RemoveAndCopyValue(Controller, Spawn))
+	{
+		Match.Spawns.Add(Spawn);
+	}
+
+	if (Match.Players.Num() == 0)
+	{
+		ResetMatch(Match);
+	}
+}
+
+void AKhopeshGameMode::BeginMatch(FKhopeshMatch& Match)
+{
+	float const Now = GetWorld()->GetTimeSeconds();
+	Match.Telemetry.Reset(Now);
+
+	for (AKhopeshPlayerController* Player : Match.Players)
+	{
+		Player->GetNetAccounting().Reset(Now);
+	}
+
+	SetDuelOpponent(Match.Players[0], Match.Players[1]);
+	SetDuelOpponent(Match.Players[1], Match.Players[0]);
+}
+
+void AKhopeshGameMode::DestroyPawn(AKhopeshPlayerController* Player)
+{
+	APawn* Pawn = Player->GetPawn();
+	if (!Pawn) return;
+
+	Player->UnPossess();
+	Pawn->Destroy();
+}
+
+void AKhopeshGameMode::InitMatches()
+{
+	TArray<AActor*> PlayerStarts;
+	UGameplayStatics::GetAllActorsOfClass(GetWorld(), APlayerStart::StaticClass(), PlayerStarts);
+
+	for (AActor* PlayerStart : PlayerStarts)
+	{
+		FName Arena = Cast<APlayerStart>(PlayerStart)->PlayerStartTag;
+		auto Match = Matches.FindByPredicate([Arena](FKhopeshMatch const& Match)
+		{
+			return Match.Arena == Arena;
+		});
+
+		if (!Match)
+		{
+			// Matches are only added here, so the indices in PlayerMatches stay valid.
+			Match = &Matches.AddDefaulted_GetRef();
+			Match->Arena = Arena;
+			Match->RematchRequestTime = 0.0;
+			Match->IsFinished = false;
+		}
+
+		Match->Spawns.Add(PlayerStart);
+	}
+}
+
+void AKhopeshGameMode::ResetMatch(FKhopeshMatch& Match)
+{
+	GetWorldTimerManager().ClearTimer(Match.ResultTimer);
+
+	for (auto const& TakenSpawn : Match.TakenSpawns)
+	{
+		Match.Spawns.Add(TakenSpawn.Value);
+	}
+
+	Match.TakenSpawns.Reset();
+	Match.RematchPlayers.Reset();
+	Match.DuelSession.Reset();
+	Match.IsFinished = false;
+}
+
+void AKhopeshGameMode::AdvanceDuel(FKhopeshMatch& Match)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshAdvanceDuel);
+
+	FKhopeshRollbackSession& Session = *Match.DuelSession;
+	if (!Session.CanAdvance()) return;
+
+	// The server only simulates confirmed frames, so it never rolls back
+	while (Session.CanAdvance())
+	{
+		Session.Advance();
+	}
+
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		auto Fighter = Cast<AKhopeshCharacter>(Match.Players[Slot]->GetPawn());
+		if (Fighter)
+		{
+			Fighter->ApplyDuelState(Session.GetState().Fighters[Slot], Session.GetRules());
+		}
+	}
+}
+
+void AKhopeshGameMode::StepCombat()
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshStepCombat);
+
+	for (FKhopeshMatch& Match : Matches)
+	{
+		for (AKhopeshPlayerController* Player : Match.Players)
+		{
+			auto Character = Cast<AKhopeshCharacter>(Player->GetPawn());
+			if (Character)
+			{
+				Character->StepCombat();
+			}
+		}
+	}
+}
+
 void AKhopeshGameMode::ShowResult(AKhopeshPlayerController* WinPlayer, AKhopeshPlayerController* LosePlayer)
 {
-	WinPlayer->ShowResultWidget(true);
-	LosePlayer->ShowResultWidget(false);
+	if (WinPlayer)
+	{
+		WinPlayer->ShowResultWidget(true);
+	}
+
+	if (LosePlayer)
+	{
+		LosePlayer->ShowResultWidget(false);
+	}
+
+	// A match left by both players has already been reset
+	int32 const MatchIndex = WinPlayer ? GetMatchIndex(WinPlayer) : GetMatchIndex(LosePlayer);
+	if (MatchIndex != INDEX_NONE)
+	{
+		WriteTelemetry(Matches[MatchIndex], WinPlayer);
+	}
+
+	++FinishedMatches;
+	WritePoolState();
+}
+
+void AKhopeshGameMode::WriteTelemetry(FKhopeshMatch const& Match, AKhopeshPlayerController* WinPlayer)
+{
+	FKhopeshMatchTelemetry const& Telemetry = Match.Telemetry;
+
+	TArray<float> FrameTimes = Telemetry.FrameTimes;
+	FrameTimes.Sort();
+
+	auto Percentile = [&FrameTimes](float Ratio)
+	{
+		return FrameTimes.Num() ? FrameTimes[FMath::Min(FMath::FloorToInt(FrameTimes.Num() * Ratio), FrameTimes.Num() - 1)] : 0.0f;
+	};
+
+	float const Duration = GetWorld()->GetTimeSeconds() - Telemetry.StartTime;
+	FString const Row = FString::Printf(TEXT("%s,%s,%d,%.1f,%d,%.3f,%.3f,%.3f,%.3f,%d,%d"),
+		*FDateTime::UtcNow().ToIso8601(), *Match.Arena.ToString(), Match.Players.Find(WinPlayer), Duration,
+		FrameTimes.Num(), Percentile(0.5f), Percentile(0.95f), Percentile(0.99f), FrameTimes.Num() ? FrameTimes.Last() : 0.0f,
+		Telemetry.Hits, Telemetry.Parries);
+
+	UE_LOG(LogKhopesh, Log, TEXT("Match : %s"), *Row);
+	CSV_EVENT(Khopesh, TEXT("Match %s"), *Match.Arena.ToString());
+
+	FString const FileName = FPaths::ProjectSavedDir() / TEXT("Telemetry") / TEXT("Matches.csv");
+	if (!FPaths::FileExists(FileName))
+	{
+		FFileHelper::SaveStringToFile(TEXT("time,arena,winner,duration,frames,frame_ms_p50,frame_ms_p95,frame_ms_p99,frame_ms_max,hits,parries\n"), *FileName);
+	}
+
+	FFileHelper::SaveStringToFile(Row + TEXT("\n"), *FileName, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	if (FKhopeshNetAccounting::IsEnabled())
+	{
+		// Connections are named by slot, so that reports of different runs line up
+		FString Report = FKhopeshNetAccounting::GetReportHeader();
+		for (int32 Slot = 0; Slot < Match.Players.Num(); ++Slot)
+		{
+			Match.Players[Slot]->GetNetAccounting().AppendReport(Report, FString::Printf(TEXT("slot%d"), Slot), GetWorld()->GetTimeSeconds());
+		}
+
+		FKhopeshNetAccounting::SaveReport(Report, FString::Printf(TEXT("%s_%s"), *Match.Arena.ToString(), *FDateTime::Now().ToString()));
+	}
+}
+
+void AKhopeshGameMode::SetDuelOpponent(APlayerController* Player, APlayerController* Opponent)
+{
+	if (auto KhopeshPlayer = Cast<AKhopeshPlayerController>(Player))
+	{
+		KhopeshPlayer->SetOpponentState(Opponent ? Opponent->PlayerState : nullptr);
+	}
+
+	// Without the graph, e.g. a listen server of the editor, relevancy falls back to the net cull distance
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	auto Graph = NetDriver ? Cast<UKhopeshReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+
+	if (Graph)
+	{
+		Graph->SetDuelOpponent(Player, Opponent);
+	}
+}
+
+void AKhopeshGameMode::WritePoolState()
+{
+	if (PoolStatePath.IsEmpty()) return;
+
+	auto GameInstance = GetGameInstance<UKhopeshGameInstance>();
+	bool const IsFinished = Matches.ContainsByPredicate([](FKhopeshMatch const& Match) { return Match.IsFinished; });
+
+	TCHAR const* State = TEXT("busy");
+	if (GameInstance && !GameInstance->IsCombatPreloaded())
+	{
+		State = TEXT("loading");
+	}
+	else if (Players.Num() == 0)
+	{
+		State = TEXT("ready");
+	}
+	else if (IsFinished)
+	{
+		State = TEXT("finished");
+	}
+
+	FString const Json = FString::Printf(TEXT("{\"state\": \"%s\", \"players\": %d, \"matches\": %d}\n"), State, Players.Num(), FinishedMatches);
+
+	// Renamed into place, so the supervisor never reads half a file
+	FString const TempPath = PoolStatePath + TEXT(".tmp");
+	if (FFileHelper::SaveStringToFile(Json, *TempPath))
+	{
+		IFileManager::Get().Move(*PoolStatePath, *TempPath, true);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshLoadRecorder.h"
+#include "Khopesh.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("RPCs Sent"), STAT_KhopeshRPCsSent, STATGROUP_Khopesh);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RPCs Received"), STAT_KhopeshRPCsReceived, STATGROUP_Khopesh);
+
+FKhopeshLoadRecorder::FKhopeshLoadRecorder()
+{
+	Elapsed = 0.0f;
+	SampleTime = 0.0f;
+	Frames = 0;
+	WorkTime = 0.0;
+	MaxWorkTime = 0.0;
+	SentRPCs = 0;
+	ReceivedRPCs = 0;
+	LastInBytes = 0;
+	LastOutBytes = 0;
+	LastInPackets = 0;
+	LastOutPackets = 0;
+}
+
+bool FKhopeshLoadRecorder::OpenFromCommandLine()
+{
+	FString FileName;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("KhopeshLoadCsv="), FileName)) return false;
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*FileName, FILEWRITE_AllowRead));
+	if (!Writer) return false;
+
+	FTCHARToUTF8 Header(TEXT("time,players,duels,frames,frame_ms_avg,frame_ms_max,rpc_sent,rpc_received,bytes_in,bytes_out,packets_in,packets_out\n"));
+	Writer->Serialize(const_cast<ANSICHAR*>(Header.Get()), Header.Length());
+	return true;
+}
+
+void FKhopeshLoadRecorder::CountSentRPC()
+{
+	++SentRPCs;
+	INC_DWORD_STAT(STAT_KhopeshRPCsSent);
+	CSV_CUSTOM_STAT(Khopesh, RPCsSent, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FKhopeshLoadRecorder::CountReceivedRPC()
+{
+	++ReceivedRPCs;
+	INC_DWORD_STAT(STAT_KhopeshRPCsReceived);
+	CSV_CUSTOM_STAT(Khopesh, RPCsReceived, 1, ECsvCustomStatOp::Accumulate);
+}
+
+double FKhopeshLoadRecorder::GetFrameWorkTime()
+{
+	return FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0);
+}
+
+void FKhopeshLoadRecorder::Tick(UWorld* World, float DeltaSeconds, int32 NumPlayers, int32 NumDuels)
+{
+	if (!Writer) return;
+
+	double const FrameWork = GetFrameWorkTime();
+	WorkTime += FrameWork;
+	MaxWorkTime = FMath::Max(MaxWorkTime, FrameWork);
+	++Frames;
+
+	Elapsed += DeltaSeconds;
+	if ((SampleTime += DeltaSeconds) >= 1.0f)
+	{
+		WriteRow(World, NumPlayers, NumDuels);
+		SampleTime = 0.0f;
+	}
+}
+
+void FKhopeshLoadRecorder::WriteRow(UWorld* World, int32 NumPlayers, int32 NumDuels)
+{
+	uint32 InBytes = 0, OutBytes = 0, InPackets = 0, OutPackets = 0;
+
+	if (auto NetDriver = World->GetNetDriver())
+	{
+		InBytes = NetDriver->InTotalBytes - LastInBytes;
+		OutBytes = NetDriver->OutTotalBytes - LastOutBytes;
+		InPackets = NetDriver->InTotalPackets - LastInPackets;
+		OutPackets = NetDriver->OutTotalPackets - LastOutPackets;
+
+		LastInBytes = NetDriver->InTotalBytes;
+		LastOutBytes = NetDriver->OutTotalBytes;
+		LastInPackets = NetDriver->InTotalPackets;
+		LastOutPackets = NetDriver->OutTotalPackets;
+	}
+
+	FString const Row = FString::Printf(TEXT("%.1f,%d,%d,%d,%.3f,%.3f,%d,%d,%u,%u,%u,%u\n"),
+		Elapsed, NumPlayers, NumDuels, Frames, WorkTime * 1000.0 / FMath::Max(Frames, 1), MaxWorkTime * 1000.0,
+		SentRPCs, ReceivedRPCs, InBytes, OutBytes, InPackets, OutPackets);
+
+	FTCHARToUTF8 Converted(*Row);
+	Writer->Serialize(const_cast<ANSICHAR*>(Converted.Get()), Converted.Length());
+	Writer->Flush();
+
+	Frames = 0;
+	WorkTime = 0.0;
+	MaxWorkTime = 0.0;
+	SentRPCs = 0;
+	ReceivedRPCs = 0;
+}
\ No newline at end of file
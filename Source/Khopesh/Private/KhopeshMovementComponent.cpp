@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshMovementComponent.h"
+#include "KhopeshCharacter.h"
+#include "KhopeshCombatProfile.h"
+
+UKhopeshMovementComponent::UKhopeshMovementComponent()
+{
+	DodgeState.HoldTime = -1.0f;
+	DodgeState.Cooldown = 0.0f;
+	DodgeState.WasHeld = false;
+	IsDodgeHeld = false;
+}
+
+FNetworkPredictionData_Client* UKhopeshMovementComponent::GetPredictionData_Client() const
+{
+	if (!ClientPredictionData)
+	{
+		auto MutableThis = const_cast<UKhopeshMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Khopesh(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UKhopeshMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+	IsDodgeHeld = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+void UKhopeshMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+	UpdateDodge(DeltaSeconds);
+}
+
+void UKhopeshMovementComponent::UpdateDodge(float DeltaSeconds)
+{
+	auto Owner = Cast<AKhopeshCharacter>(CharacterOwner);
+	if (!Owner) return;
+
+	DodgeState.Cooldown = FMath::Max(DodgeState.Cooldown - DeltaSeconds, 0.0f);
+
+	bool const IsPressed = IsDodgeHeld && !DodgeState.WasHeld;
+	DodgeState.WasHeld = IsDodgeHeld;
+
+	if (IsPressed)
+	{
+		// In combat mode a short press is a short dodge and holding past DodgeReinforceDelay is a long one
+		if (Owner->IsCombatMode)
+		{
+			DodgeState.HoldTime = 0.0f;
+		}
+		else
+		{
+			TryDodge(true);
+		}
+	}
+	else if (DodgeState.HoldTime >= 0.0f)
+	{
+		if (!IsDodgeHeld)
+		{
+			DodgeState.HoldTime = -1.0f;
+			TryDodge(false);
+		}
+		else if ((DodgeState.HoldTime += DeltaSeconds) >= Owner->GetCombatProfile()->DodgeReinforceDelay)
+		{
+			DodgeState.HoldTime = -1.0f;
+			TryDodge(true);
+		}
+	}
+}
+
+void UKhopeshMovementComponent::TryDodge(bool IsLongDodge)
+{
+	auto Owner = Cast<AKhopeshCharacter>(CharacterOwner);
+	if (DodgeState.Cooldown > 0.0f || IsFalling() || !Owner->CanDodge()) return;
+
+	DodgeState.Cooldown = Owner->GetCombatProfile()->DodgeDelay;
+
+	// Moves replayed after a server correction only rebuild the state
+	if (!CharacterOwner->bClientUpdating)
+	{
+		Owner->StartDodge(Owner->GetDodgeYaw(Acceleration), IsLongDodge);
+	}
+}
+
+void FSavedMove_Khopesh::Clear()
+{
+	Super::Clear();
+
+	StartDodgeState.HoldTime = -1.0f;
+	StartDodgeState.Cooldown = 0.0f;
+	StartDodgeState.WasHeld = false;
+	IsDodgeHeld = false;
+}
+
+uint8 FSavedMove_Khopesh::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+
+	if (IsDodgeHeld)
+	{
+		Flags |= FLAG_Custom_0;
+	}
+
+	return Flags;
+}
+
+bool FSavedMove_Khopesh::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const
+{
+	// A combined move is re-simulated with the summed delta, which is only safe while no dodge can start
+	auto KhopeshMove = static_cast<FSavedMove_Khopesh*>(NewMove.Get());
+	if (IsDodgeHeld || KhopeshMove->IsDodgeHeld || StartDodgeState.HoldTime >= 0.0f || KhopeshMove->StartDodgeState.HoldTime >= 0.0f)
+		return false;
+
+	return Super::CanCombineWith(NewMove, Character, MaxDelta);
+}
+
+void FSavedMove_Khopesh::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	auto Movement = Cast<UKhopeshMovementComponent>(Character->GetCharacterMovement());
+	IsDodgeHeld = Movement->GetDodgeHeld();
+	StartDodgeState = Movement->GetDodgeState();
+}
+
+void FSavedMove_Khopesh::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	auto Movement = Cast<UKhopeshMovementComponent>(Character->GetCharacterMovement());
+	Movement->SetDodgeState(StartDodgeState);
+}
+
+FNetworkPredictionData_Client_Khopesh::FNetworkPredictionData_Client_Khopesh(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Khopesh::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Khopesh());
+}
\ No newline at end of file
@@ -0,0 +1,283 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshNetAccounting.h"
+#include "Khopesh.h"
+#include "KhopeshPlayerController.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Engine/ActorChannel.h"
+#include "GameFramework/Actor.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	// A reference is sent as a packed NetGUID, its size depends on how many objects the connection knows
+	int32 const ObjectRefBits = 32;
+
+	// Dynamic array element count
+	int32 const ArrayCountBits = 16;
+}
+
+FName const FKhopeshNetAccounting::RPC(TEXT("rpc"));
+FName const FKhopeshNetAccounting::Property(TEXT("property"));
+
+FKhopeshNetAccounting::FKhopeshNetAccounting()
+{
+	StartTime = 0.0f;
+}
+
+void FKhopeshNetAccounting::Reset(float Time)
+{
+	Entries.Reset();
+	Seconds.Reset();
+	StartTime = Time;
+}
+
+void FKhopeshNetAccounting::Record(FName Section, FName Name, int32 Bits, float Time)
+{
+	FEntry& Entry = Entries.FindOrAdd(TPair<FName, FName>(Section, Name));
+	++Entry.Count;
+	Entry.Bits += Bits;
+
+	int32 const Second = FMath::Max(FMath::FloorToInt(Time - StartTime), 0);
+	if (Seconds.Num() <= Second)
+	{
+		Seconds.AddZeroed(Second + 1 - Seconds.Num());
+	}
+
+	++Seconds[Second].Count;
+	Seconds[Second].Bits += Bits;
+}
+
+void FKhopeshNetAccounting::AppendReport(FString& OutReport, FString const& Connection, float Time) const
+{
+	float const Duration = Time - StartTime;
+
+	for (auto const& Pair : Entries)
+	{
+		OutReport += FString::Printf(TEXT("%s,%s,%s,%d,%lld,%.1f\n"),
+			*Pair.Key.Key.ToString(), *Pair.Key.Value.ToString(), *Connection, Pair.Value.Count, Pair.Value.Bits, Duration);
+	}
+
+	for (int32 Second = 0; Second < Seconds.Num(); ++Second)
+	{
+		OutReport += FString::Printf(TEXT("second,%d,%s,%d,%lld,%.1f\n"),
+			Second, *Connection, Seconds[Second].Count, Seconds[Second].Bits, Duration);
+	}
+}
+
+bool FKhopeshNetAccounting::IsEnabled()
+{
+	static bool const IsEnabled = FParse::Param(FCommandLine::Get(), TEXT("KhopeshNetReport"));
+	return IsEnabled;
+}
+
+FString const& FKhopeshNetAccounting::GetReportHeader()
+{
+	static FString const Header(TEXT("section,name,connection,count,bits,seconds\n"));
+	return Header;
+}
+
+void FKhopeshNetAccounting::SaveReport(FString const& Report, FString const& Name)
+{
+	FString const FileName = FPaths::ProjectSavedDir() / TEXT("NetReports") / (Name + TEXT(".csv"));
+	FFileHelper::SaveStringToFile(Report, *FileName);
+	UE_LOG(LogKhopesh, Log, TEXT("Net report written to %s"), *FileName);
+}
+
+void FKhopeshNetAccounting::RecordRPC(AActor* Actor, UFunction* Function, void* Params)
+{
+	if (!IsEnabled()) return;
+
+	int32 const Bits = GetParamsBits(Function, Params);
+	float const Time = Actor->GetWorld()->GetTimeSeconds();
+
+	// Multicasts go to every connection that has the actor, client RPCs to its owner only
+	ELifetimeCondition const Condition = Function->HasAnyFunctionFlags(FUNC_NetMulticast) ? COND_None : COND_OwnerOnly;
+	ForEachConnection(Actor, Condition, [Function, Bits, Time](FKhopeshNetAccounting& Accounting)
+	{
+		Accounting.Record(RPC, Function->GetFName(), Bits, Time);
+	});
+}
+
+void FKhopeshNetAccounting::RecordProperty(AActor* Actor, UProperty* InProperty, void const* Data, ELifetimeCondition Condition)
+{
+	if (!IsEnabled()) return;
+
+	int32 const Bits = GetPropertyBits(InProperty, Data);
+	float const Time = Actor->GetWorld()->GetTimeSeconds();
+
+	ForEachConnection(Actor, Condition, [InProperty, Bits, Time](FKhopeshNetAccounting& Accounting)
+	{
+		Accounting.Record(Property, InProperty->GetFName(), Bits, Time);
+	});
+}
+
+int32 FKhopeshNetAccounting::GetParamsBits(UFunction* Function, void* Params)
+{
+	int32 Bits = 0;
+
+	// Same layout as FRepLayout::SendPropertiesForRPC : a bit per non bool parameter telling whether it differs from zero
+	for (TFieldIterator<UProperty> It(Function); It && (It->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm; ++It)
+	{
+		for (int32 Idx = 0; Idx < It->ArrayDim; ++Idx)
+		{
+			void const* Data = It->ContainerPtrToValuePtr<void>(Params, Idx);
+
+			if (It->IsA<UBoolProperty>())
+			{
+				Bits += 1;
+			}
+			else if (It->Identical(Data, nullptr))
+			{
+				Bits += 1;
+			}
+			else
+			{
+				Bits += 1 + GetPropertyBits(*It, Data);
+			}
+		}
+	}
+
+	return Bits;
+}
+
+int32 FKhopeshNetAccounting::GetPropertyBits(UProperty* InProperty, void const* Data)
+{
+	// Serializing a reference would export a NetGUID, so it is estimated instead
+	if (InProperty->IsA<UObjectPropertyBase>())
+		return ObjectRefBits;
+
+	if (auto StructProperty = Cast<UStructProperty>(InProperty))
+	{
+		// Structs without a NetSerialize are sent field by field
+		if (!(StructProperty->Struct->StructFlags & STRUCT_NetSerializeNative))
+		{
+			int32 Bits = 0;
+			for (TFieldIterator<UProperty> It(StructProperty->Struct); It; ++It)
+			{
+				if (It->PropertyFlags & CPF_RepSkip) continue;
+
+				for (int32 Idx = 0; Idx < It->ArrayDim; ++Idx)
+				{
+					Bits += GetPropertyBits(*It, It->ContainerPtrToValuePtr<void>(Data, Idx));
+				}
+			}
+
+			return Bits;
+		}
+	}
+
+	if (auto ArrayProperty = Cast<UArrayProperty>(InProperty))
+	{
+		FScriptArrayHelper Array(ArrayProperty, Data);
+
+		int32 Bits = ArrayCountBits;
+		for (int32 Idx = 0; Idx < Array.Num(); ++Idx)
+		{
+			Bits += GetPropertyBits(ArrayProperty->Inner, Array.GetRawPtr(Idx));
+		}
+
+		return Bits;
+	}
+
+	FNetBitWriter Writer(nullptr, 256);
+	InProperty->NetSerializeItem(Writer, nullptr, const_cast<void*>(Data));
+	return static_cast<int32>(Writer.GetNumBits());
+}
+
+void FKhopeshNetAccounting::ForEachConnection(AActor* Actor, ELifetimeCondition Condition, TFunctionRef<void(FKhopeshNetAccounting&)> Func)
+{
+	UNetDriver* NetDriver = Actor->GetNetDriver();
+	if (!NetDriver) return;
+
+	// A client only sends server RPCs, all of them to the server
+	if (NetDriver->ServerConnection)
+	{
+		if (auto Controller = Cast<AKhopeshPlayerController>(NetDriver->ServerConnection->PlayerController))
+		{
+			Func(Controller->GetNetAccounting());
+		}
+
+		return;
+	}
+
+	UNetConnection* Owner = Actor->GetNetConnection();
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (!Connection->FindActorChannelRef(Actor)) continue;
+		if (Condition == COND_OwnerOnly && Connection != Owner) continue;
+		if (Condition == COND_SkipOwner && Connection == Owner) continue;
+
+		if (auto Controller = Cast<AKhopeshPlayerController>(Connection->PlayerController))
+		{
+			Func(Controller->GetNetAccounting());
+		}
+	}
+}
+
+FKhopeshRepTracker::FKhopeshRepTracker()
+{
+	IsInitialized = false;
+}
+
+FKhopeshRepTracker::~FKhopeshRepTracker()
+{
+	for (FTracked const& Tracked : Properties)
+	{
+		Tracked.Property->DestroyValue(&Values[Tracked.Offset]);
+	}
+}
+
+void FKhopeshRepTracker::Update(AActor* Actor, UClass* DeclaringClass)
+{
+	if (!FKhopeshNetAccounting::IsEnabled()) return;
+
+	if (!IsInitialized)
+	{
+		Init(Actor, DeclaringClass);
+	}
+
+	for (FTracked const& Tracked : Properties)
+	{
+		void const* Current = Tracked.Property->ContainerPtrToValuePtr<void>(Actor, Tracked.Index);
+		void* Last = &Values[Tracked.Offset];
+
+		if (Tracked.Property->Identical(Current, Last)) continue;
+
+		Tracked.Property->CopySingleValue(Last, Current);
+		FKhopeshNetAccounting::RecordProperty(Actor, Tracked.Property, Current, Tracked.Condition);
+	}
+}
+
+void FKhopeshRepTracker::Init(AActor* Actor, UClass* DeclaringClass)
+{
+	IsInitialized = true;
+
+	UClass* Class = Actor->GetClass();
+	Class->SetUpRuntimeReplicationData();
+
+	TArray<FLifetimeProperty> LifetimeProps;
+	Actor->GetLifetimeReplicatedProps(LifetimeProps);
+
+	int32 Size = 0;
+	for (FLifetimeProperty const& LifetimeProp : LifetimeProps)
+	{
+		FRepRecord const& Rep = Class->ClassReps[LifetimeProp.RepIndex];
+		if (Rep.Property->GetOwnerClass() != DeclaringClass) continue;
+
+		// Room for the whole property, since initialize and destroy work on every element of a static array
+		Size = Align(Size, Rep.Property->GetMinAlignment());
+		Properties.Add({ Rep.Property, Rep.Index, LifetimeProp.Condition, Size });
+		Size += Rep.Property->GetSize();
+	}
+
+	// Starts from zero like a new channel, so the initial values are accounted too
+	Values.SetNumZeroed(Size);
+	for (FTracked const& Tracked : Properties)
+	{
+		Tracked.Property->InitializeValue(&Values[Tracked.Offset]);
+	}
+}
\ No newline at end of file
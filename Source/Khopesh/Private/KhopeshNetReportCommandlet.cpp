@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshNetReportCommandlet.h"
+#include "Khopesh.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	struct FReportEntry
+	{
+		FReportEntry() : Count(0.0), Bits(0.0) {}
+
+		double Count;
+		double Bits;
+	};
+
+	struct FReport
+	{
+		// Per second rates of every connection together, by "section name"
+		TMap<FString, FReportEntry> Entries;
+		double PeakBits;
+	};
+
+	bool LoadReport(FString const& FileName, FReport& OutReport)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *FileName) || Lines.Num() == 0)
+		{
+			UE_LOG(LogKhopesh, Error, TEXT("Cannot read net report %s"), *FileName);
+			return false;
+		}
+
+		OutReport.PeakBits = 0.0;
+		TMap<int32, double> SecondBits;
+
+		// The first line is the header
+		for (int32 Idx = 1; Idx < Lines.Num(); ++Idx)
+		{
+			TArray<FString> Columns;
+			if (Lines[Idx].ParseIntoArray(Columns, TEXT(","), false) != 6) continue;
+
+			double const Count = FCString::Atod(*Columns[3]);
+			double const Bits = FCString::Atod(*Columns[4]);
+			double const Seconds = FMath::Max(FCString::Atod(*Columns[5]), 1.0);
+
+			if (Columns[0] == TEXT("second"))
+			{
+				int32 const Second = FCString::Atoi(*Columns[1]);
+				SecondBits.Add(Second, SecondBits.FindRef(Second) + Bits);
+				continue;
+			}
+
+			FReportEntry& Entry = OutReport.Entries.FindOrAdd(Columns[0] + TEXT(" ") + Columns[1]);
+			Entry.Count += Count / Seconds;
+			Entry.Bits += Bits / Seconds;
+		}
+
+		for (auto const& Pair : SecondBits)
+		{
+			OutReport.PeakBits = FMath::Max(OutReport.PeakBits, Pair.Value);
+		}
+
+		return true;
+	}
+}
+
+UKhopeshNetReportCommandlet::UKhopeshNetReportCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UKhopeshNetReportCommandlet::Main(FString const& Params)
+{
+	FString BaseFile, NewFile;
+	float Threshold = 5.0f;
+	FParse::Value(*Params, TEXT("Base="), BaseFile);
+	FParse::Value(*Params, TEXT("New="), NewFile);
+	FParse::Value(*Params, TEXT("Threshold="), Threshold);
+
+	FReport Base, New;
+	if (!LoadReport(BaseFile, Base) || !LoadReport(NewFile, New)) return 1;
+
+	TArray<FString> Names;
+	Base.Entries.GetKeys(Names);
+	for (auto const& Pair : New.Entries)
+	{
+		Names.AddUnique(Pair.Key);
+	}
+	Names.Sort();
+
+	FReportEntry const Zero;
+	double BaseTotal = 0.0, NewTotal = 0.0;
+	int32 Regressions = 0;
+
+	UE_LOG(LogKhopesh, Display, TEXT("%-40s %12s %12s %10s %10s"), TEXT("name"), TEXT("base bit/s"), TEXT("new bit/s"), TEXT("delta"), TEXT("calls/s"));
+
+	for (FString const& Name : Names)
+	{
+		FReportEntry const& BaseEntry = Base.Entries.Contains(Name) ? Base.Entries[Name] : Zero;
+		FReportEntry const& NewEntry = New.Entries.Contains(Name) ? New.Entries[Name] : Zero;
+		BaseTotal += BaseEntry.Bits;
+		NewTotal += NewEntry.Bits;
+
+		double const Delta = (BaseEntry.Bits > 0.0) ? (NewEntry.Bits / BaseEntry.Bits - 1.0) * 100.0 : (NewEntry.Bits > 0.0 ? 100.0 : 0.0);
+		bool const IsRegression = Delta > Threshold;
+		Regressions += IsRegression;
+
+		UE_LOG(LogKhopesh, Display, TEXT("%-40s %12.1f %12.1f %9.1f%% %10.2f%s"),
+			*Name, BaseEntry.Bits, NewEntry.Bits, Delta, NewEntry.Count, IsRegression ? TEXT("  REGRESSION") : TEXT(""));
+	}
+
+	UE_LOG(LogKhopesh, Display, TEXT("Total : %.1f -> %.1f bit/s, peak second %.0f -> %.0f bits"),
+		BaseTotal, NewTotal, Base.PeakBits, New.PeakBits);
+
+	if (Regressions > 0)
+	{
+		UE_LOG(LogKhopesh, Error, TEXT("%d entries grew by more than %.1f%%"), Regressions, Threshold);
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
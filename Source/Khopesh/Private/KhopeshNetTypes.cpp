@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshNetTypes.h"
+
+bool FKhopeshStatus::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 Tenths = HP;
+	Ar.SerializeInt(Tenths, MaxHPTenths + 1);
+	HP = static_cast<uint16>(Tenths);
+
+	uint32 Flag = IsCombatMode;
+	Ar.SerializeInt(Flag, 2);
+	IsCombatMode = Flag != 0;
+
+	Ar << Speed;
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FKhopeshCombatEvents::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// 3 bits count, then 2 bits type and 0 ~ 16 bits payload per event
+	uint32 Num = Events.Num();
+	Ar.SerializeInt(Num, MaxEvents + 1);
+
+	if (Ar.IsLoading())
+	{
+		Events.SetNumZeroed(Num);
+	}
+
+	for (FKhopeshCombatEvent& Event : Events)
+	{
+		uint32 Type = static_cast<uint32>(Event.Type);
+		Ar.SerializeInt(Type, 4);
+		Event.Type = static_cast<ECombatEvent>(Type);
+
+		if (Event.Type == ECombatEvent::HIT)
+		{
+			uint32 Montage = Event.Montage;
+			Ar.SerializeInt(Montage, 16);
+			Event.Montage = static_cast<uint8>(Montage);
+		}
+		else if (Event.Type == ECombatEvent::DEFENSE_SUCCESS)
+		{
+			Event.Yaw.NetSerialize(Ar, Map, bOutSuccess);
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FKhopeshDuelInput::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 Bits = Buttons;
+	Ar.SerializeInt(Bits, 8);
+	Buttons = static_cast<uint8>(Bits);
+
+	Ar << MoveForward << MoveRight;
+	return Yaw.NetSerialize(Ar, Map, bOutSuccess);
+}
+
+bool FKhopeshDuelInputs::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 Frame = static_cast<uint32>(LastFrame);
+	uint32 Ack = static_cast<uint32>(AckFrame);
+	Ar.SerializeIntPacked(Frame);
+	Ar.SerializeIntPacked(Ack);
+	LastFrame = static_cast<int32>(Frame);
+	AckFrame = static_cast<int32>(Ack);
+
+	uint32 Num = Inputs.Num();
+	Ar.SerializeInt(Num, MaxInputs + 1);
+
+	if (Ar.IsLoading())
+	{
+		Inputs.SetNum(Num);
+	}
+
+	for (FKhopeshDuelInput& Input : Inputs)
+	{
+		Input.NetSerialize(Ar, Map, bOutSuccess);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
\ No newline at end of file
@@ -1,14 +1,138 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "KhopeshPlayerController.h"
+#include "Khopesh.h"
 #include "Kismet/GameplayStatics.h"
 #include "KhopeshGameMode.h"
+#include "KhopeshCharacter.h"
+#include "KhopeshGameInstance.h"
 #include "UnrealNetwork.h"
 #include "Engine/World.h"
 
+DECLARE_CYCLE_STAT(TEXT("ShowResultWidget"), STAT_KhopeshShowResultWidget, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("BlockInput"), STAT_KhopeshBlockInput, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("StartRematch"), STAT_KhopeshStartRematch, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("SendDuelInputs"), STAT_KhopeshSendDuelInputs, STATGROUP_Khopesh);
+DECLARE_CYCLE_STAT(TEXT("ReceiveDuelInputs"), STAT_KhopeshReceiveDuelInputs, STATGROUP_Khopesh);
+
+AKhopeshPlayerController::AKhopeshPlayerController()
+{
+	OpponentState = nullptr;
+	DuelTime = 0.0f;
+	RematchRequestTime = 0.0;
+	IsReady = false;
+}
+
 void AKhopeshPlayerController::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (IsLocalController())
+	{
+		Bot = FKhopeshBot::CreateFromCommandLine();
+		AnimBudget = MakeUnique<FKhopeshAnimBudget>();
+		EffectPool = MakeUnique<FKhopeshEffectPool>(GetWorld());
+
+		auto GameInstance = GetGameInstance<UKhopeshGameInstance>();
+		if (GameInstance)
+		{
+			GameInstance->CallWhenCombatPreloaded(FSimpleDelegate::CreateUObject(this, &AKhopeshPlayerController::ReportCombatReady));
+		}
+		else
+		{
+			ReportCombatReady();
+		}
+	}
+}
+
+void AKhopeshPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The pooled components belong to this world
+	EffectPool.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AKhopeshPlayerController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Before the duel step, so that a rollback duel records the bot input of this frame
+	if (Bot)
+	{
+		Bot->Tick(this, DeltaSeconds);
+	}
+
+	if (AnimBudget)
+	{
+		AnimBudget->Tick(this, DeltaSeconds);
+	}
+
+	auto MyCharacter = Cast<AKhopeshCharacter>(GetPawn());
+	if (!DuelSession || !MyCharacter) return;
+
+	// A fighter destroyed for a rematch before this client heard of it
+	if (!IsValid(Duel.Fighters[0]) || !IsValid(Duel.Fighters[1]))
+	{
+		DuelSession.Reset();
+		return;
+	}
+
+	// Fixed frames, catching up at most a few per tick after a stall
+	float const FrameTime = DuelSession->GetRules().FrameTime;
+	DuelTime = FMath::Min(DuelTime + DeltaSeconds, FrameTime * 4.0f);
+
+	bool IsAdvanced = false;
+	while (DuelTime >= FrameTime && DuelSession->CanAdvance())
+	{
+		DuelTime -= FrameTime;
+		DuelSession->AddLocalInput(MyCharacter->ConsumeDuelInput());
+		DuelSession->Advance();
+		IsAdvanced = true;
+	}
+
+	if (!IsAdvanced) return;
+
+	FKhopeshDuelInputs Inputs;
+	DuelSession->GetLocalInputs(Inputs);
+	SendDuelInputs(Inputs);
+
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		Duel.Fighters[Slot]->ApplyDuelState(DuelSession->GetState().Fighters[Slot], DuelSession->GetRules());
+	}
+}
+
+void AKhopeshPlayerController::AcknowledgePossession(APawn* P)
+{
+	Super::AcknowledgePossession(P);
+
+	if (RematchRequestTime > 0.0 && P)
+	{
+		double const TurnaroundMs = (FPlatformTime::Seconds() - RematchRequestTime) * 1000.0;
+		RematchRequestTime = 0.0;
+
+		UE_LOG(LogKhopesh, Log, TEXT("Rematch turnaround : %.1f ms"), TurnaroundMs);
+		CSV_EVENT(Khopesh, TEXT("Rematch %.1f ms"), TurnaroundMs);
+	}
+}
+
+void AKhopeshPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AKhopeshPlayerController, OpponentState, COND_OwnerOnly);
+}
+
+bool AKhopeshPlayerController::CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack)
+{
+	if (auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>())
+	{
+		GameMode->GetLoadRecorder().CountSentRPC();
+	}
+
+	FKhopeshNetAccounting::RecordRPC(this, Function, Parameters);
+	return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
 }
 
 void AKhopeshPlayerController::PlayerDead()
@@ -17,21 +141,129 @@ void AKhopeshPlayerController::PlayerDead()
 	World->PlayerDead(this);
 }
 
+void AKhopeshPlayerController::StartDuel(FKhopeshDuel const& NewDuel)
+{
+	auto MyCharacter = Cast<AKhopeshCharacter>(NewDuel.Fighters[NewDuel.Slot]);
+
+	FKhopeshDuelRules Rules;
+	MyCharacter->GetDuelRules(Rules);
+
+	Duel = NewDuel;
+	DuelSession = MakeUnique<FKhopeshRollbackSession>(Rules, FKhopeshRollbackSession::MakeStart(Duel), Duel.Slot);
+	DuelTime = 0.0f;
+}
+
 void AKhopeshPlayerController::BackToLobby()
 {
 	UGameplayStatics::OpenLevel(GetWorld(), TEXT("Lobby"));
 }
 
+void AKhopeshPlayerController::Rematch()
+{
+	RematchRequestTime = FPlatformTime::Seconds();
+	RequestRematch(true);
+}
+
+void AKhopeshPlayerController::NextMatch()
+{
+	RematchRequestTime = FPlatformTime::Seconds();
+	RequestRematch(false);
+}
+
 void AKhopeshPlayerController::ShowResultWidget_Implementation(bool IsWin)
 {
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshShowResultWidget);
+
 	OnShowResultWidget(IsWin);
+
+	// The server writes the report of its side, this is what the client sent
+	if (FKhopeshNetAccounting::IsEnabled() && GetNetMode() == NM_Client)
+	{
+		FString Report = FKhopeshNetAccounting::GetReportHeader();
+		NetAccounting.AppendReport(Report, TEXT("server"), GetWorld()->GetTimeSeconds());
+		FKhopeshNetAccounting::SaveReport(Report, FString::Printf(TEXT("Client_%s"), *FDateTime::Now().ToString()));
+	}
 }
 
 void AKhopeshPlayerController::BlockInput_Implementation()
 {
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshBlockInput);
+
 	StopMovement();
 	SetIgnoreMoveInput(true);
 	SetIgnoreLookInput(true);
 	SetInputMode(FInputModeUIOnly());
 	bShowMouseCursor = true;
+}
+
+void AKhopeshPlayerController::StartRematch_Implementation()
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshStartRematch);
+
+	// Undo BlockInput, the new pawn is possessed right after
+	DuelSession.Reset();
+	ResetIgnoreInputFlags();
+	SetInputMode(FInputModeGameOnly());
+	bShowMouseCursor = false;
+
+	OnStartRematch();
+}
+
+void AKhopeshPlayerController::SendDuelInputs_Implementation(FKhopeshDuelInputs const& Inputs)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshSendDuelInputs);
+
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	GameMode->GetLoadRecorder().CountReceivedRPC();
+	GameMode->ReceiveDuelInputs(this, Inputs);
+}
+
+bool AKhopeshPlayerController::SendDuelInputs_Validate(FKhopeshDuelInputs const& Inputs)
+{
+	return Inputs.Inputs.Num() > 0;
+}
+
+void AKhopeshPlayerController::ReceiveDuelInputs_Implementation(FKhopeshDuelInputs const& Inputs)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshReceiveDuelInputs);
+
+	if (DuelSession)
+	{
+		DuelSession->AddRemoteInputs(1 - DuelSession->GetLocalSlot(), Inputs);
+	}
+}
+
+void AKhopeshPlayerController::ReportCombatReady_Implementation()
+{
+	IsReady = true;
+
+	if (auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>())
+	{
+		GameMode->RestartWhenReady(this);
+	}
+}
+
+bool AKhopeshPlayerController::ReportCombatReady_Validate()
+{
+	return true;
+}
+
+void AKhopeshPlayerController::RequestRematch_Implementation(bool IsSameOpponent)
+{
+	auto GameMode = GetWorld()->GetAuthGameMode<AKhopeshGameMode>();
+	if (!GameMode) return;
+
+	if (IsSameOpponent)
+	{
+		GameMode->RequestRematch(this);
+	}
+	else
+	{
+		GameMode->RequestNextMatch(this);
+	}
+}
+
+bool AKhopeshPlayerController::RequestRematch_Validate(bool IsSameOpponent)
+{
+	return true;
 }
\ No newline at end of file
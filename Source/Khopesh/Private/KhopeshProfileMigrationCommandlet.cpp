@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshProfileMigrationCommandlet.h"
+#include "Khopesh.h"
+#include "KhopeshCharacter.h"
+#include "KhopeshCombatProfile.h"
+#include "AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+namespace
+{
+	bool SavePackage(UPackage* Package, UObject* Asset)
+	{
+		FString const FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if (UPackage::SavePackage(Package, Asset, RF_Standalone, *FileName, GWarn)) return true;
+
+		UE_LOG(LogKhopesh, Error, TEXT("Cannot save %s, is it checked out?"), *FileName);
+		return false;
+	}
+}
+
+UKhopeshProfileMigrationCommandlet::UKhopeshProfileMigrationCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UKhopeshProfileMigrationCommandlet::Main(FString const& Params)
+{
+#if WITH_EDITOR
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetFName(), Blueprints, true);
+
+	int32 Migrated = 0;
+	int32 Failed = 0;
+
+	for (FAssetData const& Asset : Blueprints)
+	{
+		auto Blueprint = Cast<UBlueprint>(Asset.GetAsset());
+		if (!Blueprint || !Blueprint->GeneratedClass || !Blueprint->GeneratedClass->IsChildOf(AKhopeshCharacter::StaticClass())) continue;
+
+		auto Defaults = Blueprint->GeneratedClass->GetDefaultObject<AKhopeshCharacter>();
+		if (Defaults->Profile || !Defaults->HasLegacyTuning()) continue;
+
+		FString const ProfileName = Blueprint->GetName() + TEXT("_Profile");
+		FString const ProfilePackageName = FPackageName::GetLongPackagePath(Blueprint->GetOutermost()->GetName()) / ProfileName;
+		if (FPackageName::DoesPackageExist(ProfilePackageName))
+		{
+			UE_LOG(LogKhopesh, Error, TEXT("%s already exists, assign it to %s by hand"), *ProfilePackageName, *Blueprint->GetName());
+			++Failed;
+			continue;
+		}
+
+		UPackage* ProfilePackage = CreatePackage(nullptr, *ProfilePackageName);
+		auto Profile = NewObject<UKhopeshCombatProfile>(ProfilePackage, *ProfileName, RF_Public | RF_Standalone);
+		Defaults->MigrateLegacyTuning(*Profile);
+		FAssetRegistryModule::AssetCreated(Profile);
+
+		// The blueprint package holds its class defaults
+		Defaults->Profile = Profile;
+		Blueprint->MarkPackageDirty();
+
+		if (!SavePackage(ProfilePackage, Profile) || !SavePackage(Blueprint->GetOutermost(), Blueprint))
+		{
+			++Failed;
+			continue;
+		}
+
+		UE_LOG(LogKhopesh, Display, TEXT("%s now uses %s"), *Blueprint->GetName(), *ProfilePackageName);
+		++Migrated;
+	}
+
+	UE_LOG(LogKhopesh, Display, TEXT("Migrated %d character blueprints, %d failed"), Migrated, Failed);
+	return Failed > 0 ? 1 : 0;
+#else
+	UE_LOG(LogKhopesh, Error, TEXT("KhopeshProfileMigration needs the editor"));
+	return 1;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshProximityGrid.h"
+#include "KhopeshCharacter.h"
+#include "Khopesh.h"
+
+DECLARE_CYCLE_STAT(TEXT("Proximity Update"), STAT_KhopeshProximityUpdate, STATGROUP_Khopesh);
+
+FKhopeshProximityGrid::FKhopeshProximityGrid()
+{
+	CellSize = 1000.0f;
+	MaxReach = 0.0f;
+}
+
+void FKhopeshProximityGrid::Init(float InCellSize)
+{
+	check(Entries.Num() == 0)
+
+	CellSize = FMath::Max(InCellSize, 1.0f);
+}
+
+void FKhopeshProximityGrid::Add(AKhopeshCharacter* Character, float Range, float Radius, int32 Group)
+{
+	if (Entries.Contains(Character)) return;
+
+	FEntry& Entry = Entries.Add(Character);
+	Entry.Character = Character;
+	Entry.Location = Character->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+	Entry.Range = Range;
+	Entry.Radius = Radius;
+	Entry.Group = Group;
+	Entry.IsMoved = false;
+
+	Cells.FindOrAdd(Entry.Cell).Add(Character);
+	MaxReach = FMath::Max(MaxReach, Range + Radius);
+
+	MarkMoved(Character);
+}
+
+void FKhopeshProximityGrid::Remove(AKhopeshCharacter* Character)
+{
+	FEntry* Entry = Entries.Find(Character);
+	if (!Entry) return;
+
+	for (AKhopeshCharacter* Other : TArray<AKhopeshCharacter*, TInlineAllocator<4>>(Entry->Near))
+	{
+		SetNear(*Entry, Entries[Other], false);
+	}
+
+	for (AKhopeshCharacter* Other : TArray<AKhopeshCharacter*, TInlineAllocator<4>>(Entry->NearBy))
+	{
+		SetNear(Entries[Other], *Entry, false);
+	}
+
+	TArray<AKhopeshCharacter*>& Cell = Cells.FindChecked(Entry->Cell);
+	Cell.RemoveSwap(Character);
+	if (Cell.Num() == 0)
+	{
+		Cells.Remove(Entry->Cell);
+	}
+
+	if (Entry->IsMoved)
+	{
+		MovedCharacters.RemoveSwap(Character);
+	}
+
+	Entries.Remove(Character);
+}
+
+void FKhopeshProximityGrid::MarkMoved(AKhopeshCharacter* Character)
+{
+	FEntry* Entry = Entries.Find(Character);
+	if (!Entry || Entry->IsMoved) return;
+
+	Entry->IsMoved = true;
+	MovedCharacters.Add(Character);
+}
+
+void FKhopeshProximityGrid::Update()
+{
+	SCOPE_CYCLE_COUNTER(STAT_KhopeshProximityUpdate);
+
+	for (int32 Idx = 0; Idx < MovedCharacters.Num(); ++Idx)
+	{
+		FEntry& Entry = Entries.FindChecked(MovedCharacters[Idx]);
+		Entry.IsMoved = false;
+		UpdateEntry(Entry);
+	}
+
+	MovedCharacters.Reset();
+}
+
+void FKhopeshProximityGrid::UpdateEntry(FEntry& Entry)
+{
+	Entry.Location = Entry.Character->GetActorLocation();
+
+	FIntPoint const NewCell = GetCell(Entry.Location);
+	if (NewCell != Entry.Cell)
+	{
+		TArray<AKhopeshCharacter*>& OldCell = Cells.FindChecked(Entry.Cell);
+		OldCell.RemoveSwap(Entry.Character);
+		if (OldCell.Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+
+		Cells.FindOrAdd(NewCell).Add(Entry.Character);
+		Entry.Cell = NewCell;
+	}
+
+	// Current neighbors plus everyone already paired with us, so leaving pairs are also re-evaluated.
+	TArray<AKhopeshCharacter*, TInlineAllocator<16>> Candidates(Entry.Near);
+	for (AKhopeshCharacter* Other : Entry.NearBy)
+	{
+		Candidates.AddUnique(Other);
+	}
+
+	int32 const Reach = FMath::CeilToInt(MaxReach / CellSize);
+	for (int32 X = -Reach; X <= Reach; ++X)
+	{
+		for (int32 Y = -Reach; Y <= Reach; ++Y)
+		{
+			auto Cell = Cells.Find(FIntPoint(Entry.Cell.X + X, Entry.Cell.Y + Y));
+			if (!Cell) continue;
+
+			for (AKhopeshCharacter* Other : *Cell)
+			{
+				if (Other != Entry.Character)
+				{
+					Candidates.AddUnique(Other);
+				}
+			}
+		}
+	}
+
+	for (AKhopeshCharacter* Other : Candidates)
+	{
+		FEntry& OtherEntry = Entries.FindChecked(Other);
+		if (OtherEntry.Group != Entry.Group) continue;
+
+		float const DistSquared = FVector::DistSquared(Entry.Location, OtherEntry.Location);
+
+		SetNear(Entry, OtherEntry, DistSquared <= FMath::Square(Entry.Range + OtherEntry.Radius));
+		SetNear(OtherEntry, Entry, DistSquared <= FMath::Square(OtherEntry.Range + Entry.Radius));
+	}
+}
+
+void FKhopeshProximityGrid::SetNear(FEntry& Observer, FEntry& Target, bool IsNear)
+{
+	if (IsNear == Observer.Near.Contains(Target.Character)) return;
+
+	if (IsNear)
+	{
+		Observer.Near.Add(Target.Character);
+		Target.NearBy.Add(Observer.Character);
+
+		if (Observer.Near.Num() == 1)
+		{
+			Observer.Character->SetEnemyNear(true);
+		}
+	}
+	else
+	{
+		Observer.Near.RemoveSwap(Target.Character);
+		Target.NearBy.RemoveSwap(Observer.Character);
+
+		if (Observer.Near.Num() == 0)
+		{
+			Observer.Character->SetEnemyNear(false);
+		}
+	}
+}
+
+FIntPoint FKhopeshProximityGrid::GetCell(FVector const& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
\ No newline at end of file
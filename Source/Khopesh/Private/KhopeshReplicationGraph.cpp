@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshReplicationGraph.h"
+#include "KhopeshCharacter.h"
+#include "Engine/NetConnection.h"
+#include "Engine/LevelScriptActor.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/Pawn.h"
+
+void UKhopeshReplicationGraphNode_Duel::GatherActorListsForConnection(FConnectionGatherActorListParameters const& Params)
+{
+	ReplicationActorList.Reset();
+
+	AddPlayer(Params.ConnectionManager.NetConnection->PlayerController);
+	AddPlayer(Opponent.Get());
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
+
+void UKhopeshReplicationGraphNode_Duel::AddPlayer(APlayerController* Player)
+{
+	if (!Player) return;
+
+	ReplicationActorList.ConditionalAdd(Player);
+	ReplicationActorList.ConditionalAdd(Player->PlayerState);
+	ReplicationActorList.ConditionalAdd(Player->GetPawn());
+}
+
+UKhopeshReplicationGraph::UKhopeshReplicationGraph()
+{
+	CellSize = 10000.0f;
+	SpatialBias = FVector2D(-100000.0f, -100000.0f);
+	CharacterCullDistance = 5000.0f;
+}
+
+void UKhopeshReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Controllers, player states and pawns of a duel are replicated through the connection nodes only
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), EClassRepNodeMapping::NOT_ROUTED);
+	ClassRepNodePolicies.Set(APlayerState::StaticClass(), EClassRepNodeMapping::NOT_ROUTED);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), EClassRepNodeMapping::NOT_ROUTED);
+	ClassRepNodePolicies.Set(AKhopeshCharacter::StaticClass(), EClassRepNodeMapping::SPATIALIZE_DORMANCY);
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated()) continue;
+
+		// Skeleton and reinstanced classes of the editor
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_"))) continue;
+
+		EClassRepNodeMapping const Mapping = GetMappingPolicy(Class);
+		bool const IsSpatialized = Mapping >= EClassRepNodeMapping::SPATIALIZE_STATIC;
+
+		// The graph replicates in frames of the server tick, not in updates per second
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.ReplicationPeriodFrame = FMath::Max<uint32>(
+			static_cast<uint32>(FMath::RoundToFloat(NetDriver->NetServerMaxTickRate / ActorCDO->NetUpdateFrequency)), 1);
+
+		if (IsSpatialized)
+		{
+			ClassInfo.CullDistanceSquared = Class->IsChildOf(AKhopeshCharacter::StaticClass())
+				? FMath::Square(CharacterCullDistance) : ActorCDO->NetCullDistanceSquared;
+		}
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UKhopeshReplicationGraph::InitGlobalGraphNodes()
+{
+	// Preallocate for a full server of duels
+	PreAllocateRepList(3, 12);
+	PreAllocateRepList(6, 12);
+	PreAllocateRepList(128, 64);
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = CellSize;
+	GridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UKhopeshReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	auto DuelNode = CreateNewNode<UKhopeshReplicationGraphNode_Duel>();
+	AddConnectionGraphNode(DuelNode, RepGraphConnection);
+	DuelNodes.Add(RepGraphConnection->NetConnection, DuelNode);
+
+	auto OwnerNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(OwnerNode, RepGraphConnection);
+	OwnerNodes.Add(RepGraphConnection->NetConnection, OwnerNode);
+}
+
+void UKhopeshReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	DuelNodes.Remove(NetConnection);
+	OwnerNodes.Remove(NetConnection);
+	Super::RemoveClientConnection(NetConnection);
+}
+
+void UKhopeshReplicationGraph::RouteAddNetworkActorToNodes(FNewReplicatedActorInfo const& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EClassRepNodeMapping::RELEVANT_ALL_CONNECTIONS:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EClassRepNodeMapping::RELEVANT_OWNER_CONNECTION:
+		if (!AddToOwnerNode(ActorInfo.Actor))
+		{
+			PendingOwnerActors.Add(ActorInfo.Actor);
+		}
+		break;
+	case EClassRepNodeMapping::SPATIALIZE_STATIC:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EClassRepNodeMapping::SPATIALIZE_DYNAMIC:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EClassRepNodeMapping::SPATIALIZE_DORMANCY:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UKhopeshReplicationGraph::RouteRemoveNetworkActorToNodes(FNewReplicatedActorInfo const& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EClassRepNodeMapping::RELEVANT_ALL_CONNECTIONS:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EClassRepNodeMapping::RELEVANT_OWNER_CONNECTION:
+		if (PendingOwnerActors.RemoveSwap(ActorInfo.Actor) == 0)
+		{
+			// The owner may have lost its connection since
+			for (auto& Pair : OwnerNodes)
+			{
+				if (Pair.Value->NotifyRemoveNetworkActor(ActorInfo, false)) break;
+			}
+		}
+		break;
+	case EClassRepNodeMapping::SPATIALIZE_STATIC:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EClassRepNodeMapping::SPATIALIZE_DYNAMIC:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EClassRepNodeMapping::SPATIALIZE_DORMANCY:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+int32 UKhopeshReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	// An actor spawned before its owner was set reaches the owner's connection once it has one
+	for (int32 Index = PendingOwnerActors.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = PendingOwnerActors[Index].Get();
+		if (!Actor || AddToOwnerNode(Actor))
+		{
+			PendingOwnerActors.RemoveAtSwap(Index);
+		}
+	}
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+void UKhopeshReplicationGraph::SetDuelOpponent(APlayerController* Player, APlayerController* Opponent)
+{
+	auto DuelNode = Player ? DuelNodes.FindRef(Player->GetNetConnection()) : nullptr;
+	if (DuelNode)
+	{
+		DuelNode->SetOpponent(Opponent);
+	}
+}
+
+EClassRepNodeMapping UKhopeshReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	if (EClassRepNodeMapping const* Policy = ClassRepNodePolicies.Get(Class))
+		return *Policy;
+
+	// Classes without an explicit policy are routed by their replication settings, and the result is cached
+	AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+	EClassRepNodeMapping Mapping = EClassRepNodeMapping::SPATIALIZE_DYNAMIC;
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		Mapping = EClassRepNodeMapping::RELEVANT_ALL_CONNECTIONS;
+	}
+	else if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		Mapping = EClassRepNodeMapping::RELEVANT_OWNER_CONNECTION;
+	}
+	else if (!ActorCDO->GetRootComponent() || ActorCDO->GetRootComponent()->Mobility == EComponentMobility::Static)
+	{
+		Mapping = EClassRepNodeMapping::SPATIALIZE_STATIC;
+	}
+
+	ClassRepNodePolicies.Set(Class, Mapping);
+	return Mapping;
+}
+
+bool UKhopeshReplicationGraph::AddToOwnerNode(AActor* Actor)
+{
+	// Owned at spawn, as weapons and infos of a player are. A later change of owner is not followed.
+	auto OwnerNode = OwnerNodes.FindRef(Actor->GetNetConnection());
+	if (!OwnerNode) return false;
+
+	OwnerNode->NotifyAddNetworkActor(FNewReplicatedActorInfo(Actor));
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshRewindBuffer.h"
+
+FKhopeshRewindBuffer::FKhopeshRewindBuffer()
+{
+	Head = 0;
+	Count = 0;
+}
+
+void FKhopeshRewindBuffer::Init(int32 Capacity)
+{
+	Frames.SetNumZeroed(FMath::Max(Capacity, 1));
+	Reset();
+}
+
+void FKhopeshRewindBuffer::Reset()
+{
+	Head = 0;
+	Count = 0;
+}
+
+void FKhopeshRewindBuffer::Record(float Time, FVector const& Location, FRotator const& Rotation)
+{
+	if (Frames.Num() == 0) return;
+
+	Head = (Head + 1) % Frames.Num();
+	Count = FMath::Min(Count + 1, Frames.Num());
+
+	FKhopeshRewindFrame& Frame = Frames[Head];
+	Frame.Time = Time;
+	Frame.Location = Location;
+	Frame.Rotation = Rotation;
+}
+
+bool FKhopeshRewindBuffer::Sample(float Time, FVector& OutLocation, FRotator& OutRotation) const
+{
+	if (Count == 0) return false;
+
+	FKhopeshRewindFrame const* Newer = &GetFrame(0);
+
+	for (int32 Age = 0; Age < Count; ++Age)
+	{
+		FKhopeshRewindFrame const& Older = GetFrame(Age);
+		if (Older.Time > Time)
+		{
+			Newer = &Older;
+			continue;
+		}
+
+		float Alpha = 0.0f;
+		if (Newer->Time > Older.Time)
+		{
+			Alpha = (Time - Older.Time) / (Newer->Time - Older.Time);
+		}
+
+		OutLocation = FMath::Lerp(Older.Location, Newer->Location, Alpha);
+		OutRotation = FQuat::Slerp(Older.Rotation.Quaternion(), Newer->Rotation.Quaternion(), Alpha).Rotator();
+		return true;
+	}
+
+	OutLocation = Newer->Location;
+	OutRotation = Newer->Rotation;
+	return true;
+}
+
+FKhopeshRewindFrame const& FKhopeshRewindBuffer::GetFrame(int32 Age) const
+{
+	return Frames[(Head - Age + Frames.Num()) % Frames.Num()];
+}
\ No newline at end of file
@@ -0,0 +1,380 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshRollback.h"
+#include "KhopeshAnimInstance.h"
+
+namespace
+{
+	bool IsAttackMontage(uint8 Montage)
+	{
+		return Montage == static_cast<uint8>(EMontage::ATTACK_WEAK) || Montage == static_cast<uint8>(EMontage::ATTACK_STRONG);
+	}
+
+	bool IsDodgeMontage(uint8 Montage)
+	{
+		return Montage == static_cast<uint8>(EMontage::DODGE_SHORT) || Montage == static_cast<uint8>(EMontage::DODGE_LONG);
+	}
+
+	void PlayMontage(FKhopeshFighterState& Fighter, EMontage Montage)
+	{
+		Fighter.Montage = static_cast<uint8>(Montage);
+		Fighter.MontageFrame = 0;
+	}
+
+	uint16 GetMontageFrames(FKhopeshDuelRules const& Rules, FKhopeshFighterState const& Fighter)
+	{
+		if (IsAttackMontage(Fighter.Montage))
+		{
+			bool const IsStrong = Fighter.Montage == static_cast<uint8>(EMontage::ATTACK_STRONG);
+			return Rules.AttackTimings[IsStrong][Fighter.Combat.Combo - 1].Frames;
+		}
+
+		return Rules.MontageFrames[Fighter.Montage];
+	}
+
+	void ResolveAttack(FKhopeshDuelRules const& Rules, FKhopeshFighterState& Attacker, FKhopeshFighterState& Defender)
+	{
+		if (Defender.HP <= 0.0f) return;
+
+		FVector const Forward = FRotator(0.0f, Attacker.Yaw, 0.0f).Vector();
+		FVector const End = Attacker.Location + Forward * Rules.AttackRange;
+		FVector const Closest = FMath::ClosestPointOnSegment(Defender.Location, Attacker.Location, End);
+		if (FVector::DistSquaredXY(Closest, Defender.Location) > FMath::Square(Rules.AttackRadius + Rules.CapsuleRadius)) return;
+
+		if (Defender.Combat.IsDefensing && FKhopeshRules::IsParried(Defender.Yaw, Attacker.Yaw))
+		{
+			Defender.Yaw = (Attacker.Location - Defender.Location).Rotation().Yaw;
+			Defender.Combat.Break(Rules.BrokenFrames);
+			PlayMontage(Attacker, EMontage::BROKEN);
+			return;
+		}
+
+		bool const IsStrong = Attacker.Montage == static_cast<uint8>(EMontage::ATTACK_STRONG);
+		Defender.HP = FMath::Clamp(Defender.HP - Rules.Stats.GetHitDamage(IsStrong, Attacker.Combat.Combo), 0.0f, FKhopeshStatus::MaxHP);
+
+		PlayMontage(Defender, (Defender.HP > 0.0f) ? GetHitMontage(FKhopeshRules::GetHitDirection(Defender.Yaw, Attacker.Yaw)) : EMontage::DIE);
+	}
+
+	void TryDodge(FKhopeshDuelRules const& Rules, FKhopeshFighterState& Fighter, FKhopeshDuelInput const& Input, bool IsLongDodge)
+	{
+		if (Fighter.DodgeDelayFrames > 0 || Fighter.Montage != FKhopeshFighterState::NoMontage) return;
+
+		FVector const Move(Input.MoveForward, Input.MoveRight, 0.0f);
+		Fighter.Yaw = Input.Yaw.Get() + (Move.IsNearlyZero() ? 0.0f : Move.Rotation().Yaw);
+		Fighter.DodgeDelayFrames = Rules.DodgeDelayFrames;
+		PlayMontage(Fighter, IsLongDodge ? EMontage::DODGE_LONG : EMontage::DODGE_SHORT);
+	}
+
+	void UpdateDodge(FKhopeshDuelRules const& Rules, FKhopeshFighterState& Fighter, FKhopeshDuelInput const& Input)
+	{
+		bool const IsHeld = (Input.Buttons & EDuelButton::DODGE) != 0;
+		bool const IsPressed = IsHeld && !Fighter.WasDodgeHeld;
+		Fighter.WasDodgeHeld = IsHeld;
+
+		// Same as UKhopeshMovementComponent::UpdateDodge, always in combat mode
+		if (IsPressed)
+		{
+			Fighter.DodgeHoldFrames = 0;
+		}
+		else if (Fighter.DodgeHoldFrames >= 0)
+		{
+			if (!IsHeld)
+			{
+				Fighter.DodgeHoldFrames = -1;
+				TryDodge(Rules, Fighter, Input, false);
+			}
+			else if (++Fighter.DodgeHoldFrames >= Rules.DodgeReinforceFrames)
+			{
+				Fighter.DodgeHoldFrames = -1;
+				TryDodge(Rules, Fighter, Input, true);
+			}
+		}
+	}
+
+	void StepFighter(FKhopeshDuelRules const& Rules, FKhopeshFighterState& Fighter, FKhopeshFighterState& Other, FKhopeshDuelInput const& Input)
+	{
+		Fighter.Combat.Step();
+
+		if (Fighter.DodgeDelayFrames > 0)
+		{
+			--Fighter.DodgeDelayFrames;
+		}
+
+		if (Fighter.Montage != FKhopeshFighterState::NoMontage)
+		{
+			++Fighter.MontageFrame;
+
+			if (IsAttackMontage(Fighter.Montage))
+			{
+				bool const IsStrong = Fighter.Montage == static_cast<uint8>(EMontage::ATTACK_STRONG);
+				if (Fighter.MontageFrame == Rules.AttackTimings[IsStrong][Fighter.Combat.Combo - 1].HitFrame)
+				{
+					ResolveAttack(Rules, Fighter, Other);
+				}
+			}
+			else if (IsDodgeMontage(Fighter.Montage))
+			{
+				bool const IsLong = Fighter.Montage == static_cast<uint8>(EMontage::DODGE_LONG);
+				float const Step = Rules.DodgeDistance[IsLong] / FMath::Max<uint16>(Rules.MontageFrames[Fighter.Montage], 1);
+				Fighter.Location += FRotator(0.0f, Fighter.Yaw, 0.0f).Vector() * Step;
+			}
+
+			// The dead stay on the last frame of the die montage
+			if (Fighter.MontageFrame >= GetMontageFrames(Rules, Fighter) && Fighter.HP > 0.0f)
+			{
+				if (IsAttackMontage(Fighter.Montage))
+				{
+					Fighter.Combat.StartComboWindow(Rules.ComboFrames);
+				}
+
+				Fighter.Montage = FKhopeshFighterState::NoMontage;
+			}
+		}
+
+		if (Fighter.HP <= 0.0f) return;
+
+		UpdateDodge(Rules, Fighter, Input);
+		if (Fighter.Montage != FKhopeshFighterState::NoMontage) return;
+
+		if (Input.Buttons & EDuelButton::ATTACK)
+		{
+			EMontage const Montage = Fighter.Combat.IsStrongMode ? EMontage::ATTACK_STRONG : EMontage::ATTACK_WEAK;
+			Fighter.Yaw = Input.Yaw.Get();
+			Fighter.Combat.StartAttack(Rules.Stats.MaxCombo);
+			PlayMontage(Fighter, Montage);
+		}
+		else if (Input.Buttons & EDuelButton::DEFENSE)
+		{
+			Fighter.Yaw = Input.Yaw.Get();
+			Fighter.Combat.StartDefense(Rules.DefenseFrames);
+			PlayMontage(Fighter, EMontage::DEFENSE);
+		}
+		else if (Input.MoveForward != 0 || Input.MoveRight != 0)
+		{
+			FVector Move(Input.MoveForward / 127.0f, Input.MoveRight / 127.0f, 0.0f);
+			Move = FRotator(0.0f, Input.Yaw.Get(), 0.0f).RotateVector(Move.GetClampedToMaxSize(1.0f));
+
+			Fighter.Location += Move * (Rules.MoveSpeed * Rules.FrameTime);
+			Fighter.Yaw = Move.Rotation().Yaw;
+		}
+	}
+}
+
+FKhopeshDuelRules::FKhopeshDuelRules()
+{
+	// Defaults for a duel without assets, overwritten from the character in a real match
+	FrameTime = FKhopeshCombatState::FrameTime;
+	MoveSpeed = 400.0f;
+	CapsuleRadius = 42.0f;
+	AttackRange = 150.0f;
+	AttackRadius = 30.0f;
+	DodgeDistance[0] = 300.0f;
+	DodgeDistance[1] = 600.0f;
+
+	for (int32 Idx = 0; Idx < 2; ++Idx)
+	{
+		AttackTimings[Idx].Init({ 0.0f, FKhopeshCombatState::ToFrames(0.3f), FKhopeshCombatState::ToFrames(0.7f) }, Stats.MaxCombo);
+	}
+
+	ComboFrames = FKhopeshCombatState::ToFrames(1.0f);
+	DefenseFrames = FKhopeshCombatState::ToFrames(0.5f);
+	BrokenFrames = FKhopeshCombatState::ToFrames(1.5f);
+	DodgeDelayFrames = FKhopeshCombatState::ToFrames(1.0f);
+	DodgeReinforceFrames = FKhopeshCombatState::ToFrames(0.2f);
+
+	MontageFrames.Init(FKhopeshCombatState::ToFrames(0.8f), static_cast<int32>(EMontage::DIE) + 1);
+	MontageFrames[static_cast<int32>(EMontage::BROKEN)] = BrokenFrames;
+}
+
+FKhopeshRollbackSession::FKhopeshRollbackSession(FKhopeshDuelRules const& InRules, FKhopeshDuelSnapshot const& Start, int32 InLocalSlot)
+	: Rules(InRules), State(Start), LocalSlot(InLocalSlot)
+{
+	for (FFrameInput& FrameInput : FrameInputs)
+	{
+		FrameInput.Frame = INDEX_NONE;
+	}
+
+	// Nobody can press anything during the first InputDelay frames
+	for (int32 Frame = Start.Frame; Frame < Start.Frame + InputDelay; ++Frame)
+	{
+		FFrameInput& FrameInput = GetFrameInput(Frame);
+		FrameInput.IsConfirmed[0] = FrameInput.IsConfirmed[1] = true;
+	}
+
+	LastLocalFrame = RemoteAckFrame = Start.Frame + InputDelay - 1;
+	ConfirmedFrames[0] = ConfirmedFrames[1] = Start.Frame + InputDelay - 1;
+	RollbackFrame = INDEX_NONE;
+	LastRollbackFrames = 0;
+}
+
+void FKhopeshRollbackSession::AddLocalInput(FKhopeshDuelInput const& Input)
+{
+	check(LocalSlot != INDEX_NONE);
+
+	LastLocalFrame = State.Frame + InputDelay;
+	FFrameInput& FrameInput = GetFrameInput(LastLocalFrame);
+	FrameInput.Inputs[LocalSlot] = Input;
+	FrameInput.IsConfirmed[LocalSlot] = true;
+	ConfirmedFrames[LocalSlot] = LastLocalFrame;
+}
+
+void FKhopeshRollbackSession::AddRemoteInput(int32 Slot, int32 Frame, FKhopeshDuelInput const& Input)
+{
+	// Inputs are taken in order only, and never so far ahead that they overwrite a frame we may roll back to
+	if (Slot == LocalSlot || Frame != ConfirmedFrames[Slot] + 1) return;
+	if (Frame >= State.Frame - MaxRollbackFrames + BufferSize) return;
+
+	FFrameInput& FrameInput = GetFrameInput(Frame);
+	if (Frame < State.Frame && FrameInput.Inputs[Slot] != Input)
+	{
+		RollbackFrame = (RollbackFrame == INDEX_NONE) ? Frame : FMath::Min(RollbackFrame, Frame);
+	}
+
+	FrameInput.Inputs[Slot] = Input;
+	FrameInput.IsConfirmed[Slot] = true;
+	ConfirmedFrames[Slot] = Frame;
+}
+
+void FKhopeshRollbackSession::AddRemoteInputs(int32 Slot, FKhopeshDuelInputs const& Inputs)
+{
+	int32 const FirstFrame = Inputs.LastFrame - Inputs.Inputs.Num() + 1;
+	for (int32 Idx = 0; Idx < Inputs.Inputs.Num(); ++Idx)
+	{
+		AddRemoteInput(Slot, FirstFrame + Idx, Inputs.Inputs[Idx]);
+	}
+
+	if (Slot != LocalSlot)
+	{
+		RemoteAckFrame = FMath::Max(RemoteAckFrame, Inputs.AckFrame);
+	}
+}
+
+void FKhopeshRollbackSession::GetLocalInputs(FKhopeshDuelInputs& OutInputs) const
+{
+	check(LocalSlot != INDEX_NONE);
+
+	int32 const Num = FMath::Clamp(LastLocalFrame - RemoteAckFrame, 1, FKhopeshDuelInputs::MaxInputs);
+	OutInputs.LastFrame = LastLocalFrame;
+	OutInputs.AckFrame = ConfirmedFrames[1 - LocalSlot];
+	OutInputs.Inputs.Reset();
+
+	for (int32 Frame = LastLocalFrame - Num + 1; Frame <= LastLocalFrame; ++Frame)
+	{
+		OutInputs.Inputs.Add(FrameInputs[Frame % BufferSize].Inputs[LocalSlot]);
+	}
+}
+
+bool FKhopeshRollbackSession::CanAdvance() const
+{
+	// The server never predicts
+	if (LocalSlot == INDEX_NONE)
+	{
+		return ConfirmedFrames[0] >= State.Frame && ConfirmedFrames[1] >= State.Frame;
+	}
+
+	// Stall instead of predicting further than a rollback can repair
+	return State.Frame - ConfirmedFrames[1 - LocalSlot] < MaxRollbackFrames;
+}
+
+void FKhopeshRollbackSession::Advance()
+{
+	check(CanAdvance());
+	LastRollbackFrames = 0;
+
+	if (RollbackFrame != INDEX_NONE)
+	{
+		int32 const TargetFrame = State.Frame;
+		State = Snapshots[RollbackFrame % BufferSize];
+		check(State.Frame == RollbackFrame);
+
+		LastRollbackFrames = TargetFrame - RollbackFrame;
+		RollbackFrame = INDEX_NONE;
+
+		while (State.Frame < TargetFrame)
+		{
+			SimulateFrame();
+		}
+	}
+
+	SimulateFrame();
+}
+
+FKhopeshDuelSnapshot FKhopeshRollbackSession::MakeStart(FKhopeshDuel const& Duel)
+{
+	FKhopeshDuelSnapshot Start;
+	Start.Frame = 0;
+
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		FKhopeshFighterState& Fighter = Start.Fighters[Slot];
+		Fighter.Location = Duel.Locations[Slot];
+		Fighter.Yaw = Duel.Yaws[Slot].Get();
+		Fighter.HP = Duel.HP;
+
+		// Every duel opens with the equip montage
+		Fighter.Montage = static_cast<uint8>(EMontage::EQUIP);
+		Fighter.MontageFrame = 0;
+		Fighter.Combat = FKhopeshCombatState();
+
+		Fighter.DodgeDelayFrames = 0;
+		Fighter.DodgeHoldFrames = -1;
+		Fighter.WasDodgeHeld = false;
+	}
+
+	return Start;
+}
+
+void FKhopeshRollbackSession::Simulate(FKhopeshDuelRules const& Rules, FKhopeshDuelSnapshot& State, FKhopeshDuelInput const (&Inputs)[2])
+{
+	FKhopeshFighterState& First = State.Fighters[0];
+	FKhopeshFighterState& Second = State.Fighters[1];
+
+	StepFighter(Rules, First, Second, Inputs[0]);
+	StepFighter(Rules, Second, First, Inputs[1]);
+
+	// Capsules do not overlap
+	FVector Offset = Second.Location - First.Location;
+	Offset.Z = 0.0f;
+
+	float const Overlap = Rules.CapsuleRadius * 2.0f - Offset.Size();
+	if (Overlap > 0.0f)
+	{
+		FVector const Push = Offset.GetSafeNormal(SMALL_NUMBER, FVector::ForwardVector) * (Overlap * 0.5f);
+		First.Location -= Push;
+		Second.Location += Push;
+	}
+
+	++State.Frame;
+}
+
+FKhopeshRollbackSession::FFrameInput& FKhopeshRollbackSession::GetFrameInput(int32 Frame)
+{
+	FFrameInput& FrameInput = FrameInputs[Frame % BufferSize];
+
+	if (FrameInput.Frame != Frame)
+	{
+		FrameInput.Inputs[0] = FrameInput.Inputs[1] = FKhopeshDuelInput();
+		FrameInput.IsConfirmed[0] = FrameInput.IsConfirmed[1] = false;
+		FrameInput.Frame = Frame;
+	}
+
+	return FrameInput;
+}
+
+void FKhopeshRollbackSession::SimulateFrame()
+{
+	Snapshots[State.Frame % BufferSize] = State;
+	FFrameInput& FrameInput = GetFrameInput(State.Frame);
+
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		if (FrameInput.IsConfirmed[Slot]) continue;
+
+		// Predict that the held state does not change and nothing new is pressed
+		FKhopeshDuelInput Predicted = FrameInputs[(State.Frame - 1) % BufferSize].Inputs[Slot];
+		Predicted.Buttons &= EDuelButton::DODGE;
+		FrameInput.Inputs[Slot] = Predicted;
+	}
+
+	Simulate(Rules, State, FrameInput.Inputs);
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshRollbackCommandlet.h"
+#include "Khopesh.h"
+#include "KhopeshRollback.h"
+
+namespace
+{
+	// Keeps the previous input most frames, like a player holding a direction
+	FKhopeshDuelInput MakeRandomInput(FRandomStream& Random, FKhopeshDuelInput const& Previous)
+	{
+		FKhopeshDuelInput Input = Previous;
+		Input.Buttons &= EDuelButton::DODGE;
+
+		if (Random.FRand() < 0.1f)
+		{
+			Input.MoveForward = static_cast<int8>(Random.RandRange(-127, 127));
+			Input.MoveRight = static_cast<int8>(Random.RandRange(-127, 127));
+			Input.Yaw = FKhopeshYaw(Random.FRandRange(-180.0f, 180.0f));
+		}
+
+		if (Random.FRand() < 0.05f) Input.Buttons |= EDuelButton::ATTACK;
+		if (Random.FRand() < 0.02f) Input.Buttons |= EDuelButton::DEFENSE;
+		if (Random.FRand() < 0.02f) Input.Buttons ^= EDuelButton::DODGE;
+
+		return Input;
+	}
+}
+
+UKhopeshRollbackCommandlet::UKhopeshRollbackCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UKhopeshRollbackCommandlet::Main(FString const& Params)
+{
+	int32 Frames = 36000;
+	int32 Latency = 6;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+	FParse::Value(*Params, TEXT("Latency="), Latency);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	// Beyond this the session stalls instead of rolling back
+	Latency = FMath::Clamp(Latency, 0, FKhopeshRollbackSession::MaxRollbackFrames - 1);
+
+	FKhopeshDuel Duel;
+	Duel.Locations[0] = FVector(0.0f, 0.0f, 0.0f);
+	Duel.Locations[1] = FVector(200.0f, 0.0f, 0.0f);
+	Duel.Yaws[0] = FKhopeshYaw(0.0f);
+	Duel.Yaws[1] = FKhopeshYaw(180.0f);
+	Duel.HP = 100.0f;
+
+	FKhopeshDuelRules const Rules;
+	FKhopeshDuelSnapshot const Start = FKhopeshRollbackSession::MakeStart(Duel);
+
+	// Snapshot save and restore alone, the cost paid per resimulated frame on top of Simulate
+	{
+		int32 const Count = 1000000;
+		FKhopeshDuelSnapshot Ring[32];
+
+		double const StartTime = FPlatformTime::Seconds();
+		for (int32 Idx = 0; Idx < Count; ++Idx)
+		{
+			Ring[Idx % 32] = Start;
+			Ring[Idx % 32].Frame = Idx;
+		}
+
+		double const Elapsed = FPlatformTime::Seconds() - StartTime;
+		UE_LOG(LogKhopesh, Display, TEXT("Snapshot : %d bytes, %.1f ns per save (last frame %d)"),
+			static_cast<int32>(sizeof(FKhopeshDuelSnapshot)), Elapsed * 1.0e9 / Count, Ring[(Count - 1) % 32].Frame);
+	}
+
+	FRandomStream Random(Seed);
+	FKhopeshDuelInput LocalInput, RemoteInput;
+	int64 RollbackFrames = 0;
+	int32 Rollbacks = 0;
+	int32 Duels = 0;
+	double TotalTime = 0.0;
+	double MaxTime = 0.0;
+
+	// Duels are played back to back until Frames is reached
+	TUniquePtr<FKhopeshRollbackSession> Session;
+	int32 RemoteFrame = 0;
+
+	for (int32 Frame = 0; Frame < Frames; ++Frame)
+	{
+		if (!Session || Session->GetState().Fighters[0].HP <= 0.0f || Session->GetState().Fighters[1].HP <= 0.0f)
+		{
+			Session = MakeUnique<FKhopeshRollbackSession>(Rules, Start, 0);
+			RemoteFrame = FKhopeshRollbackSession::InputDelay;
+			++Duels;
+		}
+
+		LocalInput = MakeRandomInput(Random, LocalInput);
+		Session->AddLocalInput(LocalInput);
+
+		// The remote peer is Latency frames behind, so each of its changed inputs corrects a prediction
+		while (RemoteFrame <= Session->GetFrame() + FKhopeshRollbackSession::InputDelay - Latency)
+		{
+			RemoteInput = MakeRandomInput(Random, RemoteInput);
+			Session->AddRemoteInput(1, RemoteFrame++, RemoteInput);
+		}
+
+		double const StartTime = FPlatformTime::Seconds();
+		Session->Advance();
+		double const Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		TotalTime += Elapsed;
+		MaxTime = FMath::Max(MaxTime, Elapsed);
+
+		if (Session->GetLastRollbackFrames() > 0)
+		{
+			RollbackFrames += Session->GetLastRollbackFrames();
+			++Rollbacks;
+		}
+	}
+
+	UE_LOG(LogKhopesh, Display, TEXT("Advance : %d frames in %d duels, %.2f us average, %.2f us max, budget %.0f us per frame"),
+		Frames, Duels, TotalTime * 1.0e6 / FMath::Max(Frames, 1), MaxTime * 1.0e6, Rules.FrameTime * 1.0e6);
+	UE_LOG(LogKhopesh, Display, TEXT("Rollback : %d rollbacks, %.2f frames resimulated on average"),
+		Rollbacks, static_cast<double>(RollbackFrames) / FMath::Max(Rollbacks, 1));
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshSwingTrace.h"
+
+FKhopeshSwingTrace::FKhopeshSwingTrace()
+{
+	EndTime = 0.0f;
+	SubstepTime = 0.0f;
+	Damage = 0.0f;
+	IsRecording = false;
+}
+
+void FKhopeshSwingTrace::Start(FKhopeshBladeSample const& Sample, float Duration, float SubstepRate, float InDamage)
+{
+	Pending.Reset();
+	HitActors.Reset();
+
+	EndTime = Sample.Time + Duration;
+	SubstepTime = 1.0f / FMath::Max(SubstepRate, 1.0f);
+	Damage = InDamage;
+	IsRecording = Duration > 0.0f;
+
+	LastSample = Sample;
+	AddSegments(Sample);
+}
+
+void FKhopeshSwingTrace::Record(FKhopeshBladeSample const& Sample)
+{
+	if (!IsRecording) return;
+
+	// Straight interpolation of hilt and tip is close enough to the blade arc at the sub-step rate
+	float const DeltaTime = Sample.Time - LastSample.Time;
+	int32 const Substeps = FMath::Max(FMath::CeilToInt(DeltaTime / SubstepTime), 1);
+
+	for (int32 Step = 1; Step <= Substeps; ++Step)
+	{
+		float const Alpha = static_cast<float>(Step) / Substeps;
+
+		FKhopeshBladeSample Substep;
+		Substep.Time = FMath::Lerp(LastSample.Time, Sample.Time, Alpha);
+
+		for (int32 Blade = 0; Blade < 2; ++Blade)
+		{
+			Substep.Base[Blade] = FMath::Lerp(LastSample.Base[Blade], Sample.Base[Blade], Alpha);
+			Substep.Tip[Blade] = FMath::Lerp(LastSample.Tip[Blade], Sample.Tip[Blade], Alpha);
+		}
+
+		AddSegments(Substep);
+	}
+
+	LastSample = Sample;
+	IsRecording = Sample.Time < EndTime;
+}
+
+bool FKhopeshSwingTrace::TryAddHit(AActor* Target)
+{
+	if (HitActors.Contains(Target)) return false;
+
+	HitActors.Add(Target);
+	return true;
+}
+
+void FKhopeshSwingTrace::AddSegments(FKhopeshBladeSample const& Sample)
+{
+	for (int32 Blade = 0; Blade < 2; ++Blade)
+	{
+		Pending.Add({ Sample.Time, Sample.Base[Blade], Sample.Tip[Blade] });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshCharacter.h"
+#include "KhopeshAnimInstance.h"
+#include "KhopeshCombatProfile.h"
+#include "KhopeshCountingMalloc.h"
+#include "KhopeshGameMode.h"
+#include "KhopeshPlayerController.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	int32 const WarmupRounds = 3;
+	int32 const MeasuredRounds = 5;
+	int32 const MaxWaitFrames = 600;
+
+	// Attack with a hit, attack into a parry, short dodge, long dodge
+	int32 const NumSteps = 4;
+
+	UWorld* GetGameWorld()
+	{
+		for (FWorldContext const& Context : GEngine->GetWorldContexts())
+		{
+			if (Context.WorldType == EWorldType::Game && Context.World())
+			{
+				return Context.World();
+			}
+		}
+
+		return nullptr;
+	}
+
+	FKhopeshYaw GetYawTo(AActor const* From, AActor const* To)
+	{
+		return FKhopeshYaw((To->GetActorLocation() - From->GetActorLocation()).Rotation().Yaw);
+	}
+}
+
+// Plays rounds of attacks, hits, parries and dodges between two characters matched in an arena of the stage, and fails
+// when the combat code allocates on the game thread during the measured rounds. Hits go through the swing trace, the
+// rewind and TakeDamage as in a match. The characters tick inside the measured window, the engine animates them outside
+// of it. Montage instances are created by the engine and only reported.
+class FKhopeshCombatAllocCommand : public IAutomationLatentCommand
+{
+public:
+	// Constructor
+	explicit FKhopeshCombatAllocCommand(FAutomationTestBase* InTest)
+		: Test(InTest), IsSpawned(false), Round(0), Step(0), WaitFrames(0), MeasuredHits(0) {}
+
+	// Virtual Function
+	virtual bool Update() override;
+
+private:
+	// Other Function
+	bool Spawn(UWorld* World);
+	void StartRound();
+	void PlayStep(AKhopeshCharacter* Attacker, AKhopeshCharacter* Defender);
+	void Finish();
+
+	// Other Variable
+	FAutomationTestBase* Test;
+	TWeakObjectPtr<AKhopeshCharacter> Fighters[2];
+	TWeakObjectPtr<AKhopeshPlayerController> Controllers[2];
+	FVector StartLocations[2];
+	bool IsSpawned;
+	int32 Round;
+	int32 Step;
+	int32 WaitFrames;
+	int32 MeasuredHits;
+	FKhopeshCountingMalloc CountingMalloc;
+};
+
+bool FKhopeshCombatAllocCommand::Update()
+{
+	UWorld* World = GetGameWorld();
+
+	if (!IsSpawned)
+	{
+		IsSpawned = true;
+		if (Spawn(World)) return false;
+
+		Finish();
+		return true;
+	}
+
+	// Fighters swap roles every round
+	AKhopeshCharacter* Attacker = Fighters[Round % 2].Get();
+	AKhopeshCharacter* Defender = Fighters[1 - Round % 2].Get();
+	if (!World || !Attacker || !Defender)
+	{
+		Test->AddError(TEXT("The stage or a fighter was destroyed during the test"));
+		Finish();
+		return true;
+	}
+
+	bool const IsMeasured = Round >= WarmupRounds;
+	float const DeltaSeconds = World->GetDeltaSeconds();
+
+	if (IsMeasured)
+	{
+		CountingMalloc.Begin();
+	}
+
+	Attacker->Tick(DeltaSeconds);
+	Defender->Tick(DeltaSeconds);
+	Attacker->StepCombat();
+	Defender->StepCombat();
+
+	bool const IsIdle = !Attacker->Anim->IsMontagePlay() && !Defender->Anim->IsMontagePlay();
+	if (IsIdle)
+	{
+		PlayStep(Attacker, Defender);
+	}
+
+	if (IsMeasured)
+	{
+		CountingMalloc.End();
+	}
+
+	if (!IsIdle)
+	{
+		if (++WaitFrames < MaxWaitFrames) return false;
+
+		Test->AddError(TEXT("The montages of a step never ended"));
+		Finish();
+		return true;
+	}
+
+	// Step 1 was just played, the hit of step 0 is over
+	if (IsMeasured && Step == 1 && Defender->HP < Defender->Profile->HP)
+	{
+		++MeasuredHits;
+	}
+
+	WaitFrames = 0;
+	if (++Step < NumSteps) return false;
+
+	Step = 0;
+	if (++Round < WarmupRounds + MeasuredRounds)
+	{
+		StartRound();
+		return false;
+	}
+
+	Test->AddInfo(FString::Printf(TEXT("The engine made %d montage allocations"), CountingMalloc.GetEngineAllocs()));
+
+	if (MeasuredHits == 0)
+	{
+		Test->AddError(TEXT("No swing hit during the measured rounds, the damage path was not measured"));
+	}
+
+	if (CountingMalloc.GetAllocs() > 0)
+	{
+		Test->AddError(FString::Printf(TEXT("Combat allocated %d times, %llu bytes, during the measured rounds"),
+			CountingMalloc.GetAllocs(), CountingMalloc.GetBytes()));
+	}
+
+	Finish();
+	return true;
+}
+
+bool FKhopeshCombatAllocCommand::Spawn(UWorld* World)
+{
+	auto GameMode = World ? World->GetAuthGameMode<AKhopeshGameMode>() : nullptr;
+	if (!GameMode)
+	{
+		Test->AddError(TEXT("The stage does not run the Khopesh game mode"));
+		return false;
+	}
+
+	// The blueprint pawn gives the meshes, the animation and the profile, the native class leaves the effect events empty
+	auto Template = GameMode->DefaultPawnClass ? Cast<AKhopeshCharacter>(GameMode->DefaultPawnClass->GetDefaultObject()) : nullptr;
+	if (!Template || !Template->Profile)
+	{
+		Test->AddError(TEXT("The default pawn is not a Khopesh character with a combat profile"));
+		return false;
+	}
+
+	FVector Origin = FVector::ZeroVector;
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Origin = It->GetActorLocation();
+		break;
+	}
+
+	// Beside the local player's pawn, close enough that every attack reaches
+	StartLocations[0] = Origin + FVector(0.0f, 600.0f, 0.0f);
+	StartLocations[1] = StartLocations[0] + FVector(150.0f, 0.0f, 0.0f);
+
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		Controllers[Index] = World->SpawnActor<AKhopeshPlayerController>();
+	}
+
+	// Opponents of each other, so that a swing finds its target
+	if (!GameMode->BeginTestMatch(Controllers[0].Get(), Controllers[1].Get()))
+	{
+		Test->AddError(TEXT("The stage has no free arena for the fighters"));
+		return false;
+	}
+
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		FTransform const Transform(StartLocations[Index]);
+		auto Fighter = World->SpawnActorDeferred<AKhopeshCharacter>(
+			AKhopeshCharacter::StaticClass(), Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+
+		USkeletalMeshComponent* Mesh = Fighter->GetMesh();
+		Mesh->SetRelativeTransform(Template->GetMesh()->GetRelativeTransform());
+		Mesh->SetSkeletalMesh(Template->GetMesh()->SkeletalMesh);
+		Mesh->SetAnimInstanceClass(Template->GetMesh()->AnimClass);
+		Fighter->LeftWeapon->SetStaticMesh(Template->LeftWeapon->GetStaticMesh());
+		Fighter->RightWeapon->SetStaticMesh(Template->RightWeapon->GetStaticMesh());
+		Fighter->Profile = Template->Profile;
+		Fighter->FinishSpawning(Transform);
+		Fighters[Index] = Fighter;
+		Controllers[Index]->Possess(Fighter);
+
+		// The notifies would call back from the engine's animation tick, PlayStep calls them instead
+		Fighter->Anim->OnAttack.Unbind();
+		Fighter->Anim->OnNextCombo.Unbind();
+		Fighter->Anim->OnSetCombatMode.Unbind();
+		Fighter->SetActorTickEnabled(false);
+
+		// Equipped without the equip montage
+		Fighter->SetCombat(true);
+		Fighter->SetEnemyNear(true);
+	}
+
+	StartRound();
+	CountingMalloc.Reset();
+	return true;
+}
+
+void FKhopeshCombatAllocCommand::StartRound()
+{
+	// Facing each other, as the knock backs and dodges of the last round left them
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		AKhopeshCharacter* Fighter = Fighters[Index].Get();
+		FRotator const Rotation(0.0f, Index == 0 ? 0.0f : 180.0f, 0.0f);
+		Fighter->SetActorLocationAndRotation(StartLocations[Index], Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		Fighter->HP = Fighter->Profile->HP;
+	}
+}
+
+void FKhopeshCombatAllocCommand::PlayStep(AKhopeshCharacter* Attacker, AKhopeshCharacter* Defender)
+{
+	float const InputTime = Attacker->GetWorld()->GetTimeSeconds();
+	FKhopeshYaw const AttackYaw = GetYawTo(Attacker, Defender);
+	FKhopeshYaw const DefenseYaw = GetYawTo(Defender, Attacker);
+
+	switch (Step)
+	{
+	case 0:
+		// As the Attack and NextCombo notifies would, the swing is traced and resolved by the next ticks
+		Attacker->Attack_Request_Implementation(AttackYaw, InputTime);
+		Attacker->OnAttack();
+		Attacker->OnNextCombo();
+		break;
+	case 1:
+		Defender->Defense_Request_Implementation(DefenseYaw);
+		Attacker->Attack_Request_Implementation(AttackYaw, InputTime);
+		Attacker->OnAttack();
+		break;
+	case 2:
+		Attacker->StartDodge(DefenseYaw, false);
+		break;
+	case 3:
+		Defender->StartDodge(AttackYaw, true);
+		break;
+	}
+}
+
+void FKhopeshCombatAllocCommand::Finish()
+{
+	UWorld* World = GetGameWorld();
+	auto GameMode = World ? World->GetAuthGameMode<AKhopeshGameMode>() : nullptr;
+
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		if (Fighters[Index].IsValid())
+		{
+			Fighters[Index]->Destroy();
+		}
+
+		if (Controllers[Index].IsValid())
+		{
+			if (GameMode)
+			{
+				GameMode->EndTestMatch(Controllers[Index].Get());
+			}
+
+			Controllers[Index]->Destroy();
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKhopeshCombatAllocTest, "Khopesh.Combat.NoAllocation",
+	EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+// Same rule as UKhopeshAllocCommandlet, through the character instead of the rollback simulation
+bool FKhopeshCombatAllocTest::RunTest(FString const& Parameters)
+{
+	// The combat code expects the game mode of the stage
+	AutomationOpenMap(TEXT("/Game/Map/Stage"));
+	ADD_LATENT_AUTOMATION_COMMAND(FKhopeshCombatAllocCommand(this));
+	return true;
+}
+
+#endif
\ No newline at end of file
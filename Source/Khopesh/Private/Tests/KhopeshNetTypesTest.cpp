@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshNetTypes.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKhopeshYawReplicationTest, "Khopesh.NetTypes.YawChangeIsReplicated",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+// Replication sends a struct property when UScriptStruct::CompareScriptStruct finds it changed
+bool FKhopeshYawReplicationTest::RunTest(FString const& Parameters)
+{
+	FKhopeshDodge Sent;
+	Sent.Count = 1;
+	Sent.IsLongDodge = false;
+	Sent.Yaw = FKhopeshYaw(0.0f);
+
+	FKhopeshDodge Turned = Sent;
+	Turned.Yaw = FKhopeshYaw(90.0f);
+
+	UScriptStruct* DodgeStruct = FKhopeshDodge::StaticStruct();
+	TestTrue(TEXT("The same dodge is not dirty"), DodgeStruct->CompareScriptStruct(&Sent, &Sent, 0));
+	TestFalse(TEXT("A dodge with another yaw is dirty"), DodgeStruct->CompareScriptStruct(&Sent, &Turned, 0));
+
+	FKhopeshDuel Duel;
+	Duel.Yaws[0] = FKhopeshYaw(0.0f);
+	Duel.Yaws[1] = FKhopeshYaw(180.0f);
+
+	FKhopeshDuel TurnedDuel = Duel;
+	TurnedDuel.Yaws[1] = FKhopeshYaw(90.0f);
+
+	UScriptStruct* DuelStruct = FKhopeshDuel::StaticStruct();
+	TestTrue(TEXT("The same duel is not dirty"), DuelStruct->CompareScriptStruct(&Duel, &Duel, 0));
+	TestFalse(TEXT("A duel with another yaw is dirty"), DuelStruct->CompareScriptStruct(&Duel, &TurnedDuel, 0));
+
+	return true;
+}
+
+#endif
\ No newline at end of file
@@ -4,4 +4,9 @@
 
 #include "Engine.h"
 #include "UnrealNetwork.h"
-#include "Online.h"
\ No newline at end of file
+#include "Online.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogKhopesh, Log, All);
+DECLARE_STATS_GROUP(TEXT("Khopesh"), STATGROUP_Khopesh, STATCAT_Advanced);
+CSV_DECLARE_CATEGORY_EXTERN(Khopesh);
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KhopeshAllocCommandlet.generated.h"
+
+// Plays scripted combos, defenses and dodges through a client and a server rollback session, and fails when the
+// game thread allocates during the measured frames.
+// Usage : UE4Editor-Cmd Khopesh -run=KhopeshAlloc [Frames=18000] [Warmup=600] [Latency=4]
+UCLASS()
+class UKhopeshAllocCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshAllocCommandlet();
+
+	// Virtual Function
+	virtual int32 Main(FString const& Params) override;
+};
\ No newline at end of file
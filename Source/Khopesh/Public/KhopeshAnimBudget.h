@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class APlayerController;
+class USkeletalMeshComponent;
+
+// Spreads a per-frame animation budget (khopesh.AnimBudgetMs, set per platform through device profiles) over the
+// characters a client sees. Near visible characters update every frame, far or hidden ones every few frames, and
+// dead ones stop once their death montage is over. Characters with authority are left alone, so the server keeps
+// every anim notify on its frame.
+class KHOPESH_API FKhopeshAnimBudget
+{
+public:
+	// Constructor
+	FKhopeshAnimBudget();
+
+public:
+	// Public Function
+	void Tick(APlayerController* Controller, float DeltaSeconds);
+
+	// Graph update and evaluation time, reported by the anim proxies from any thread
+	static void AddWork(uint64 Cycles, int32 Updates);
+
+private:
+	// Other Function
+	// Reschedules the mesh tick only when its rate or the frame time really changed
+	void ApplyRate(USkeletalMeshComponent* Mesh, int32 Rate);
+
+private:
+	// Other Variable
+	struct FAppliedRate
+	{
+		int32 Rate;
+		float Interval;
+	};
+
+	// Smoothed cost of one graph update with its evaluation
+	float UpdateCostMs;
+
+	// Smoothed frame time the tick intervals are made of
+	float FrameTime;
+
+	TMap<TWeakObjectPtr<USkeletalMeshComponent>, FAppliedRate> AppliedRates;
+};
\ No newline at end of file
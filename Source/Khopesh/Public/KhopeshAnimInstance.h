@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "KhopeshRules.h"
 #include "KhopeshAnimInstance.generated.h"
 
 DECLARE_DELEGATE(FOnAttack)
@@ -29,6 +31,32 @@ enum class EMontage : uint8
 	DIE,
 };
 
+// HIT_FRONT ~ HIT_RIGHT follow the order of EHitDirection
+inline EMontage GetHitMontage(EHitDirection Direction)
+{
+	return static_cast<EMontage>(static_cast<uint8>(EMontage::HIT_FRONT) + static_cast<uint8>(Direction));
+}
+
+// Sets the graph variables from the movement of the owner on the game thread, before the graph is updated on a
+// worker thread. The worker thread only reads them.
+USTRUCT()
+struct FKhopeshAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FKhopeshAnimInstanceProxy() {}
+	FKhopeshAnimInstanceProxy(UAnimInstance* Instance) : FAnimInstanceProxy(Instance) {}
+
+protected:
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void UpdateAnimationNode(float DeltaSeconds) override;
+	virtual void EvaluateAnimationNode(FPoseContext& Output) override;
+
+private:
+	TWeakObjectPtr<class UCharacterMovementComponent> Movement;
+};
+
 UCLASS()
 class KHOPESH_API UKhopeshAnimInstance : public UAnimInstance
 {
@@ -40,11 +68,12 @@ public:
 
 private:
 	// Virtual Function
-	virtual void NativeBeginPlay() override;
-	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return &Proxy; }
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
 
 public:
 	// Public Function
+	void SetProfile(class UKhopeshCombatProfile* NewProfile) { Profile = NewProfile; }
 	void PlayMontage(EMontage Montage);
 	void JumpToSection(EMontage Montage, FName const& Section);
 
@@ -52,6 +81,12 @@ public:
 	bool IsMontagePlay(EMontage Montage) const;
 	UAnimMontage* Get(EMontage Montage) const;
 
+#if WITH_EDITOR
+	// Editor Function
+	// Montages of a blueprint saved before the combat profiles, see AKhopeshCharacter::MigrateLegacyTuning
+	void MigrateLegacyMontages(class UKhopeshCombatProfile& OutProfile) const;
+#endif
+
 private:
 	// Binding Function
 	UFUNCTION()
@@ -73,56 +108,63 @@ public:
 	FOnSetCombatMode OnSetCombatMode;
 
 private:
-	// Animations
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* AttackWeak;
+	// Montages of the owner, see UKhopeshCombatProfile
+	UPROPERTY(Transient)
+	class UKhopeshCombatProfile* Profile;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* AttackStrong;
+	// Blueprint Property
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pawn, Meta = (AllowPrivateAccess = true))
+	float Speed;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* Defense;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pawn, Meta = (AllowPrivateAccess = true))
+	bool IsInAir;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* DodgeShort;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pawn, Meta = (AllowPrivateAccess = true))
+	bool IsCombatMode;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* DodgeLong;
+#if WITH_EDITORONLY_DATA
+	// Only loaded to be moved into a combat profile
+	UPROPERTY()
+	UAnimMontage* AttackWeak_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* HitFront;
+	UPROPERTY()
+	UAnimMontage* AttackStrong_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* HitLeft;
+	UPROPERTY()
+	UAnimMontage* Defense_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* HitBack;
+	UPROPERTY()
+	UAnimMontage* DodgeShort_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* HitRight;
+	UPROPERTY()
+	UAnimMontage* DodgeLong_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* Broken;
+	UPROPERTY()
+	UAnimMontage* HitFront_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* Equip;
+	UPROPERTY()
+	UAnimMontage* HitLeft_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* Unequip;
+	UPROPERTY()
+	UAnimMontage* HitBack_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, Meta = (AllowPrivateAccess = true))
-	UAnimMontage* Die;
-	
-	// Blueprint Property
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pawn, Meta = (AllowPrivateAccess = true))
-	float Speed;
+	UPROPERTY()
+	UAnimMontage* HitRight_DEPRECATED;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pawn, Meta = (AllowPrivateAccess = true))
-	bool IsInAir;
+	UPROPERTY()
+	UAnimMontage* Broken_DEPRECATED;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pawn, Meta = (AllowPrivateAccess = true))
-	bool IsCombatMode;
+	UPROPERTY()
+	UAnimMontage* Equip_DEPRECATED;
+
+	UPROPERTY()
+	UAnimMontage* Unequip_DEPRECATED;
+
+	UPROPERTY()
+	UAnimMontage* Die_DEPRECATED;
+#endif
+
+	FKhopeshAnimInstanceProxy Proxy;
 
-	// Animation Map
-	TMap<EMontage, UAnimMontage*> MontageMap;
+	friend struct FKhopeshAnimInstanceProxy;
 };
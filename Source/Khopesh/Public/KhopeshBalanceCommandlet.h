@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KhopeshBalanceCommandlet.generated.h"
+
+// Headless balance sweep over millions of scripted duels, using the stats of a combat profile, given directly or
+// through the character class that uses it.
+// Usage : UE4Editor-Cmd Khopesh -run=KhopeshBalance (Profile=/Game/... | Character=/Game/...) [Duels=1000000] [Seed=0]
+//         [HP=100] [Attack0=0.5] [Defense0=0.3] [Error0=90] [Attack1=0.5] [Defense1=0.3] [Error1=90]
+UCLASS()
+class UKhopeshBalanceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshBalanceCommandlet();
+
+	// Virtual Function
+	virtual int32 Main(FString const& Params) override;
+};
\ No newline at end of file
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AKhopeshCharacter;
+class APlayerController;
+
+enum class EBotStrategy : uint8
+{
+	RANDOM,
+	AGGRESSIVE,
+	DEFENSIVE,
+};
+
+// Drives the local character through the same bindings as the keyboard, so that a headless client produces the
+// RPC and movement traffic of a real player. Enabled with -KhopeshBot[=Random|Aggressive|Defensive] [-BotSeed=N].
+class KHOPESH_API FKhopeshBot
+{
+public:
+	// Constructor
+	FKhopeshBot(EBotStrategy InStrategy, int32 Seed);
+
+public:
+	// Public Function
+	void Tick(APlayerController* Controller, float DeltaSeconds);
+
+	// Null unless the command line asks for a bot
+	static TUniquePtr<FKhopeshBot> CreateFromCommandLine();
+
+private:
+	// Other Function
+	void Decide(AKhopeshCharacter* Character, float Distance);
+	AKhopeshCharacter* FindEnemy(AKhopeshCharacter* Character) const;
+
+private:
+	// Other Variable
+	FRandomStream Random;
+	EBotStrategy Strategy;
+
+	// Chances per decision, set from the strategy
+	float AttackChance;
+	float DefenseChance;
+	float DodgeChance;
+
+	float DecisionTime;
+	float DodgeHoldTime;
+	float MoveForward;
+	float MoveRight;
+	float AimError;
+};
\ No newline at end of file
@@ -4,17 +4,29 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "KhopeshRewindBuffer.h"
+#include "KhopeshSwingTrace.h"
+#include "KhopeshNetTypes.h"
+#include "KhopeshCombatState.h"
+#include "KhopeshRollback.h"
+#include "KhopeshNetAccounting.h"
 #include "KhopeshCharacter.generated.h"
 
 enum class EMontage : uint8;
+enum class ECombatEffect : uint8;
 
 UCLASS(config=Game)
 class AKhopeshCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend class UKhopeshMovementComponent;
+	friend class FKhopeshBot;
+	friend class FKhopeshCombatAllocCommand;
+	friend class UKhopeshProfileMigrationCommandlet;
+
 private:
-	// Components
+	// Components, the camera is unregistered on a dedicated server
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = true))
 	class USpringArmComponent* CameraBoom;
 
@@ -29,17 +41,46 @@ private:
 
 public:
 	// Constructor
-	AKhopeshCharacter();
+	AKhopeshCharacter(const FObjectInitializer& ObjectInitializer);
+
+	// Public Function
+	void SetEnemyNear(bool IsNear);
+	void StepCombat();
+	float GetHP() const { return HP; }
+	void GetStats(FKhopeshStats& OutStats) const;
+	class UKhopeshCombatProfile const* GetCombatProfile() const { return Profile; }
+
+	// Rollback Duel Function
+	void StartDuel(FKhopeshDuel const& NewDuel);
+	void GetDuelRules(FKhopeshDuelRules& OutRules) const;
+	FKhopeshDuelInput ConsumeDuelInput();
+	void ApplyDuelState(FKhopeshFighterState const& State, FKhopeshDuelRules const& Rules);
+
+#if WITH_EDITOR
+	// Editor Function
+	// A blueprint saved before the combat profiles, see UKhopeshProfileMigrationCommandlet
+	bool HasLegacyTuning() const;
+	void MigrateLegacyTuning(class UKhopeshCombatProfile& OutProfile) const;
+#endif
 
 private:
 	// Virtual Function
+	virtual void PostInitializeComponents() override;
+#if WITH_EDITOR
+	virtual void PreSave(class ITargetPlatform const* TargetPlatform) override;
+#endif
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PossessedBy(AController* NewController) override;
 	virtual void Tick(float DelatSeconds) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+	virtual bool IsNetRelevantFor(AActor const* RealViewer, AActor const* ViewTarget, FVector const& SrcLocation) const override;
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	virtual float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
+	virtual bool CallRemoteFunction(UFunction* Function, void* Parameters, struct FOutParmRec* OutParms, FFrame* Stack) override;
 
-	// Binding Function (Excluding dodge bind function because it include RPC)
+	// Binding Function
 	void MoveForward(float Value);
 	void MoveRight(float Value);
 
@@ -50,50 +91,28 @@ private:
 	void OnReleaseDodge();
 
 	void OnAttack();
+	void OnNextCombo();
 	void SetCombat(bool IsEquip);
+	void OnCapsuleMoved(USceneComponent* Component, EUpdateTransformFlags Flags, ETeleportType Teleport);
 
 	// RPC Function Declaration
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Attack_Request(FRotator NewRotation);
-
-	UFUNCTION(NetMulticast, Reliable)
-	void Attack_Response(EMontage Montage, FName Section, FRotator NewRotation);
-
-	UFUNCTION(Server, Reliable, WithValidation)
-	void Defense_Request(FRotator NewRotation);
+	void Attack_Request(FKhopeshYaw NewYaw, float InputTime);
 
 	UFUNCTION(NetMulticast, Reliable)
-	void Defense_Response(FRotator NewRotation);
+	void Attack_Response(EMontage Montage, uint8 Combo, FKhopeshYaw NewYaw);
 
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Dodge_Request(FRotator NewRotation, bool IsLongDodge);
+	void Defense_Request(FKhopeshYaw NewYaw);
 
 	UFUNCTION(NetMulticast, Reliable)
-	void Dodge_Response(FRotator NewRotation, bool IsLongDodge);
+	void Defense_Response(FKhopeshYaw NewYaw);
 
 	UFUNCTION(Client, Reliable)
 	void ShowCombatEffect();
 
-	UFUNCTION(Client, Reliable)
-	void ShowHitEffect();
-
-	UFUNCTION(Client, Reliable)
-	void ShowParryingEffect();
-
-	UFUNCTION(Client, Reliable)
-	void ApplyEnemyHP(float HP);
-
 	UFUNCTION(NetMulticast, Reliable)
-	void PlayHitSound();
-
-	UFUNCTION(NetMulticast, Reliable)
-	void PlayHitMontage(EMontage Montage);
-
-	UFUNCTION(NetMulticast, Reliable)
-	void EndDefenseMontage(bool IsSuccess, FRotator Rotator = FRotator());
-
-	UFUNCTION(NetMulticast, Reliable)
-	void PlayBroken();
+	void PlayCombatEvents(FKhopeshCombatEvents const& Events);
 
 	UFUNCTION(NetMulticast, Reliable)
 	void PlayEquip(bool IsEquip);
@@ -106,33 +125,32 @@ private:
 
 private:
 	// RPC Function Implementation
-	void Attack_Request_Implementation(FRotator NewRotation);
-	bool Attack_Request_Validate(FRotator NewRotation);
-	void Attack_Response_Implementation(EMontage Montage, FName Section, FRotator NewRotation);
-
-	void Defense_Request_Implementation(FRotator NewRotation);
-	bool Defense_Request_Validate(FRotator NewRotation);
-	void Defense_Response_Implementation(FRotator NewRotation);
+	void Attack_Request_Implementation(FKhopeshYaw NewYaw, float InputTime);
+	bool Attack_Request_Validate(FKhopeshYaw NewYaw, float InputTime);
+	void Attack_Response_Implementation(EMontage Montage, uint8 Combo, FKhopeshYaw NewYaw);
 
-	void Dodge_Request_Implementation(FRotator NewRotation, bool IsLongDodge);
-	bool Dodge_Request_Validate(FRotator NewRotation, bool IsLongDodge);
-	void Dodge_Response_Implementation(FRotator NewRotation, bool IsLongDodge);
+	void Defense_Request_Implementation(FKhopeshYaw NewYaw);
+	bool Defense_Request_Validate(FKhopeshYaw NewYaw);
+	void Defense_Response_Implementation(FKhopeshYaw NewYaw);
 
 	void ShowCombatEffect_Implementation();
-	void ShowHitEffect_Implementation();
-	void ShowParryingEffect_Implementation();
 
-	void PlayHitSound_Implementation();
-	void ApplyEnemyHP_Implementation(float HP);
-
-	void PlayHitMontage_Implementation(EMontage Montage);
-	void EndDefenseMontage_Implementation(bool IsSuccess, FRotator Rotator);
-	void PlayBroken_Implementation();
+	void PlayCombatEvents_Implementation(FKhopeshCombatEvents const& Events);
 	void PlayEquip_Implementation(bool IsEquip);
 	void SetWeapon_Implementation(bool IsEquip);
 
 	void PlayDie_Implementation();
 
+	// Replication Function
+	UFUNCTION()
+	void OnRep_Status();
+
+	UFUNCTION()
+	void OnRep_Dodge();
+
+	UFUNCTION()
+	void OnRep_Duel();
+
 protected:
 	// Blueprint Function
 	UFUNCTION(BlueprintImplementableEvent)
@@ -153,14 +171,29 @@ protected:
 private:
 	// Other Function
 	void Move(EAxis::Type Axis, float Value);
+	void SetActorYaw(FKhopeshYaw Yaw);
+	bool PlayEffect(ECombatEffect Effect);
 	void Break(AKhopeshCharacter* Target);
 	void Die();
+	void MarkStatusDirty();
+	void ApplyHP();
+	void WakeTick();
+	void UpdateTickInterval();
+
+	void PushCombatEvent(FKhopeshCombatEvent const& Event);
+	void FlushCombatEvents();
+	void ApplyCombatEvent(FKhopeshCombatEvent const& Event);
 
 	bool CanDodge() const;
-	bool IsEnemyNear() const;
+	void StartDodge(FKhopeshYaw Yaw, bool IsLongDodge);
+	FKhopeshYaw GetDodgeYaw(FVector const& InputAcceleration) const;
+	bool IsAttackable() const;
+	bool GetRewoundTransform(float Time, FVector& OutLocation, FRotator& OutRotation) const;
+	bool HasBladeSockets() const;
+	FKhopeshBladeSample GetBladeSample() const;
+	void ResolveSwing();
+	float GetAttackRewindTime() const;
 	FRotator GetRotationByAim() const;
-	FRotator GetRotationByInputKey() const;
-	EMontage GetHitMontageByDir(float Dir) const;
 
 private:
 	// Animation Instance
@@ -168,79 +201,102 @@ private:
 	class UKhopeshAnimInstance* Anim;
 
 	// Blueprint Property
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Replicated, Meta = (AllowPrivateAccess = true))
+	// Starts at the HP of the profile
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
 	float HP;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float CombatSwapRange;
+	// Tuning and montages shared by every character of this class
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat, Meta = (AllowPrivateAccess = true))
+	class UKhopeshCombatProfile* Profile;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float AttackRange;
+	// Used by a blueprint without a profile. Without either, the character spawns but never fights.
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UKhopeshCombatProfile> DefaultProfile;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float AttackRadius;
+#if WITH_EDITORONLY_DATA
+	// Tuning of a blueprint saved before the combat profiles, only loaded to be moved into one. HP is still loaded
+	// into HP.
+	UPROPERTY()
+	float CombatSwapRange_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float WeakAttackDamage;
+	UPROPERTY()
+	float AttackRange_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float StrongAttackDamage;
+	UPROPERTY()
+	float AttackRadius_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	uint8 MaxCombo;
+	UPROPERTY()
+	float WeakAttackDamage_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float ComboDuration;
+	UPROPERTY()
+	float StrongAttackDamage_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float DefenseDuration;
+	UPROPERTY()
+	uint8 MaxCombo_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float BrokenDuration;
+	UPROPERTY()
+	float ComboDuration_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stat, Meta = (AllowPrivateAccess = true))
-	float DodgeDelay;
+	UPROPERTY()
+	float DefenseDuration_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Speed, Meta = (AllowPrivateAccess = true))
-	float ReadySpeed;
+	UPROPERTY()
+	float BrokenDuration_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Speed, Meta = (AllowPrivateAccess = true))
-	float FightSpeed;
+	UPROPERTY()
+	float DodgeDelay_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Speed, Meta = (AllowPrivateAccess = true))
-	float SpeedRate;
+	UPROPERTY()
+	float ReadySpeed_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Dodge, Meta = (AllowPrivateAccess = true))
-	float DodgeReinforceDelay;
+	UPROPERTY()
+	float FightSpeed_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = KnockBack, Meta = (AllowPrivateAccess = true))
-	float HitKnockBackImpulse;
+	UPROPERTY()
+	float SpeedRate_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = HitNum, Meta = (AllowPrivateAccess = true))
-	TArray<uint8> WeakAttackHitNum;
+	UPROPERTY()
+	float DodgeReinforceDelay_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = HitNum, Meta = (AllowPrivateAccess = true))
-	TArray<uint8> StrongAttackHitNum;
+	UPROPERTY()
+	float HitKnockBackImpulse_DEPRECATED;
 
-	// Replicated Property (HP exclude here. Because it include Blueprint Property.)
-	UPROPERTY(Replicated)
-	float Speed;
+	UPROPERTY()
+	TArray<uint8> WeakAttackHitNum_DEPRECATED;
+
+	UPROPERTY()
+	TArray<uint8> StrongAttackHitNum_DEPRECATED;
+#endif
+
+	// Replicated Property (HP, Speed and IsCombatMode are sent through Status)
+	UPROPERTY(ReplicatedUsing = OnRep_Status)
+	FKhopeshStatus Status;
 
 	UPROPERTY(Replicated)
-	bool IsCombatMode;
+	bool IsStartCombat;
+
+	UPROPERTY(ReplicatedUsing = OnRep_Dodge)
+	FKhopeshDodge LastDodge;
+
+	UPROPERTY(ReplicatedUsing = OnRep_Duel)
+	FKhopeshDuel Duel;
 
 	// Other Variable
-	FTimerHandle ComboTimer, DefenseTimer, BrokenTimer, DodgeTimer;
-	uint8 CurrentCombo;
+	float Speed;
+	bool IsCombatMode;
+	FKhopeshCombatState Combat;
+	FKhopeshRewindBuffer RewindBuffer;
+	FKhopeshSwingTrace Swing;
+	EVisibilityBasedAnimTickOption DefaultAnimTickOption;
+	FKhopeshRepTracker RepTracker;
+	FKhopeshCombatEvents PendingCombatEvents;
 	float BrokenPlayRate;
-	float NextDodgeTime;
+	float AttackRewindDelay;
+	FKhopeshDuelInput PendingDuelInput;
+	FKhopeshFighterState AppliedDuelState;
 
 	// Flag Variable
 		// Server
-	bool IsStrongMode;
-	bool IsStartCombat;
-	bool IsDefensing;
-
-		// Owner
-	bool IsReadyDodge;
+	bool IsEnemyNear;
+	bool IsRollbackDuel;
 };
\ No newline at end of file
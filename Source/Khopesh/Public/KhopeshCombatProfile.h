@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "KhopeshAnimInstance.h"
+#include "KhopeshEffectPool.h"
+#include "KhopeshCombatProfile.generated.h"
+
+struct FKhopeshStats;
+
+// Tuning and montages of a fighter, shared by every character that references it. Never written at runtime.
+// The montages are soft references in the Combat bundle and the effects in the Effect bundle, both preloaded by
+// UKhopeshGameInstance.
+UCLASS(BlueprintType)
+class KHOPESH_API UKhopeshCombatProfile : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshCombatProfile();
+
+	// Virtual Function
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+public:
+	// Public Function
+	UAnimMontage* GetMontage(EMontage Montage) const { return MontageTable[static_cast<int32>(Montage)]; }
+
+	// Montage section of a combo, from 1 to MaxCombo
+	FName GetComboSection(uint8 Combo) const { return ComboSections[Combo]; }
+
+	void GetStats(FKhopeshStats& OutStats) const;
+	FKhopeshEffectSettings const& GetEffect(ECombatEffect Effect) const;
+
+	// Resolves the loaded montages into the lookup tables
+	void BuildTables();
+
+	// Loads on the spot whatever the preload did not, for a map opened without the game instance
+	void LoadMontages();
+
+	static FPrimaryAssetType GetAssetType() { return TEXT("KhopeshCombatProfile"); }
+	static FName const CombatBundle;
+	static FName const EffectBundle;
+
+public:
+	// Stat
+	// HP a character starts with, up to FKhopeshStatus::MaxHP
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat, Meta = (ClampMin = 0, ClampMax = 100))
+	float HP;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float CombatSwapRange;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float AttackRange;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float AttackRadius;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float WeakAttackDamage;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float StrongAttackDamage;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	uint8 MaxCombo;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float ComboDuration;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float DefenseDuration;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float BrokenDuration;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stat)
+	float DodgeDelay;
+
+	// Speed
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Speed)
+	float ReadySpeed;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Speed)
+	float FightSpeed;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Speed)
+	float SpeedRate;
+
+	// Dodge
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Dodge)
+	float DodgeReinforceDelay;
+
+	// Trace
+	// Time the blades can hit after the Attack notify
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Trace)
+	float SwingDuration;
+
+	// Blade samples per second between two server frames
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Trace)
+	float TraceSubstepRate;
+
+	// Sockets of the weapon mesh. Without them the blade is AttackRange straight ahead of the character.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Trace)
+	FName BladeBaseSocket;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Trace)
+	FName BladeTipSocket;
+
+	// KnockBack
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = KnockBack)
+	float HitKnockBackImpulse;
+
+	// HitNum
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = HitNum)
+	TArray<uint8> WeakAttackHitNum;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = HitNum)
+	TArray<uint8> StrongAttackHitNum;
+
+	// Rewind
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Rewind)
+	float MaxRewindTime;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Rewind)
+	int32 RewindBufferSize;
+
+	// Tick
+	// Tick interval while nothing needs a per-frame update, see AKhopeshCharacter::UpdateTickInterval
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Tick)
+	float IdleTickInterval;
+
+	// Effects
+	// Played through FKhopeshEffectPool. An empty one falls back to its blueprint event.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	FKhopeshEffectSettings CombatEffect;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	FKhopeshEffectSettings HitEffect;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	FKhopeshEffectSettings ParryingEffect;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	FKhopeshEffectSettings HitSound;
+
+	// Animations
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> AttackWeak;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> AttackStrong;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> Defense;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> DodgeShort;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> DodgeLong;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> HitFront;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> HitLeft;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> HitBack;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> HitRight;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> Broken;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> Equip;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> Unequip;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, Meta = (AssetBundles = "Combat"))
+	TSoftObjectPtr<UAnimMontage> Die;
+
+private:
+	// Lookup Table
+	// Indexed by EMontage, START has no montage. Also holds the loaded montages.
+	UPROPERTY(Transient)
+	TArray<UAnimMontage*> MontageTable;
+
+	// Indexed by combo, so that an attack never builds a name
+	TArray<FName> ComboSections;
+};
\ No newline at end of file
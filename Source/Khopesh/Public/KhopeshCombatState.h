@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Windows of FKhopeshCombatState, also the bits returned by Step for the windows that closed.
+namespace ECombatWindow
+{
+	enum Type : uint8
+	{
+		COMBO = 1 << 0,
+		DEFENSE = 1 << 1,
+		BROKEN = 1 << 2,
+	};
+}
+
+// Combat state machine of one character. Every window is a frame count advanced at the fixed FrameTime,
+// so combo and parry results only depend on how many frames passed between actions.
+struct KHOPESH_API FKhopeshCombatState
+{
+	static constexpr float FrameTime = 1.0f / 60.0f;
+
+	static uint16 ToFrames(float Seconds) { return static_cast<uint16>(FMath::CeilToInt(Seconds / FrameTime)); }
+
+	FKhopeshCombatState();
+
+	uint8 Step();
+
+	// Returns the combo section to play, from 1 to MaxCombo
+	uint8 StartAttack(uint8 MaxCombo);
+	void StartComboWindow(uint16 Frames);
+	void ResetCombo();
+
+	void StartDefense(uint16 Frames);
+	void Break(uint16 Frames);
+
+	bool IsIdle() const { return (ComboFrames | DefenseFrames | BrokenFrames) == 0; }
+
+	// Last played combo section, 0 after the combo window ran out
+	uint8 Combo;
+
+	// Remaining frames of each window, 0 when closed
+	uint16 ComboFrames;
+	uint16 DefenseFrames;
+	uint16 BrokenFrames;
+
+	bool IsDefensing;
+	bool IsStrongMode;
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+
+// Marks allocations the engine makes on the game's behalf, e.g. the instance of every montage played.
+// FKhopeshCountingMalloc counts them apart from the game's own.
+struct FKhopeshEngineAllocScope
+{
+	FKhopeshEngineAllocScope() { ++GetDepth(); }
+	~FKhopeshEngineAllocScope() { --GetDepth(); }
+
+	static bool IsOpen() { return GetDepth() > 0; }
+
+private:
+	static int32& GetDepth()
+	{
+		static int32 Depth = 0;
+		return Depth;
+	}
+};
+
+// Forwards to the real allocator and counts the calls made by one thread while installed.
+// Used by UKhopeshAllocCommandlet and the combat allocation test.
+class FKhopeshCountingMalloc final : public FMalloc
+{
+public:
+	FKhopeshCountingMalloc() : Inner(nullptr), ThreadId(0), Allocs(0), Bytes(0), EngineAllocs(0) {}
+
+	void Begin()
+	{
+		Inner = GMalloc;
+		ThreadId = FPlatformTLS::GetCurrentThreadId();
+		GMalloc = this;
+	}
+
+	void End()
+	{
+		GMalloc = Inner;
+		ThreadId = 0;
+	}
+
+	void Reset()
+	{
+		Allocs = 0;
+		Bytes = 0;
+		EngineAllocs = 0;
+	}
+
+	int32 GetAllocs() const { return Allocs; }
+	uint64 GetBytes() const { return Bytes; }
+	int32 GetEngineAllocs() const { return EngineAllocs; }
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		Record(Count);
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		Record(Count);
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual TCHAR const* GetDescriptiveName() override { return TEXT("KhopeshCountingMalloc"); }
+
+private:
+	void Record(SIZE_T Count)
+	{
+		// A free or shrink to zero is not an allocation
+		if (Count == 0 || FPlatformTLS::GetCurrentThreadId() != ThreadId) return;
+
+		if (FKhopeshEngineAllocScope::IsOpen())
+		{
+			++EngineAllocs;
+			return;
+		}
+
+		++Allocs;
+		Bytes += Count;
+	}
+
+	FMalloc* Inner;
+	uint32 ThreadId;
+	int32 Allocs;
+	uint64 Bytes;
+	int32 EngineAllocs;
+};
\ No newline at end of file
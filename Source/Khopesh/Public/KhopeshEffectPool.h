@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "KhopeshEffectPool.generated.h"
+
+class UWorld;
+class UParticleSystem;
+class UParticleSystemComponent;
+class USoundBase;
+class UAudioComponent;
+
+UENUM()
+enum class ECombatEffect : uint8
+{
+	COMBAT,
+	HIT,
+	PARRYING,
+	HIT_SOUND,
+};
+
+// Particle and sound of one combat effect, either may be empty.
+USTRUCT(BlueprintType)
+struct FKhopeshEffectSettings
+{
+	GENERATED_BODY()
+
+	FKhopeshEffectSettings() : MaxInstances(4), Priority(0) {}
+
+	bool IsEmpty() const { return Particle.IsNull() && Sound.IsNull(); }
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect, Meta = (AssetBundles = "Effect"))
+	TSoftObjectPtr<UParticleSystem> Particle;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect, Meta = (AssetBundles = "Effect"))
+	TSoftObjectPtr<USoundBase> Sound;
+
+	// Instances playing at once, past it the oldest one restarts
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	int32 MaxInstances;
+
+	// Past khopesh.MaxEffects, a new effect takes over the oldest instance of a lower or equal priority
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	int32 Priority;
+};
+
+// Particle and audio components of the combat effects a client plays, reused instead of spawned per hit, so that
+// a fast combo neither allocates nor feeds the garbage collector. At most khopesh.EffectCreatesPerFrame components
+// are created in one frame, and at most khopesh.MaxEffects play at once.
+class KHOPESH_API FKhopeshEffectPool : public FGCObject
+{
+public:
+	// Constructor
+	explicit FKhopeshEffectPool(UWorld* InWorld);
+	virtual ~FKhopeshEffectPool();
+
+	// Virtual Function
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+public:
+	// Public Function
+	// False when the settings have nothing loaded to play
+	bool Play(ECombatEffect Effect, FKhopeshEffectSettings const& Settings, FVector const& Location, FRotator const& Rotation);
+
+private:
+	struct FInstance
+	{
+		UParticleSystemComponent* Particle;
+		UAudioComponent* Sound;
+		ECombatEffect Effect;
+		int32 Priority;
+		float StartTime;
+	};
+
+	// Other Function
+	int32 Acquire(ECombatEffect Effect, FKhopeshEffectSettings const& Settings);
+	int32 FindVictim(int32 Priority, TFunctionRef<bool(FInstance const&)> Predicate) const;
+	bool IsPlaying(FInstance const& Instance) const;
+
+private:
+	// Other Variable
+	TWeakObjectPtr<UWorld> World;
+	TArray<FInstance> Instances;
+
+	uint64 CreateFrame;
+	int32 FrameCreates;
+
+	// Totals for the report
+	int32 Requests;
+	int32 Reused;
+	int32 Created;
+	int32 Stolen;
+	int32 Dropped;
+};
\ No newline at end of file
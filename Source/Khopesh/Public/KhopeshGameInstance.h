@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/GameInstance.h"
+#include "KhopeshGameInstance.generated.h"
+
+struct FStreamableHandle;
+
+// Starts loading every combat profile and its montages as soon as the game runs, so that the Lobby hides the load
+// and a match map only loads its own level. Also logs how long each map takes to load and to show its first frame.
+UCLASS()
+class KHOPESH_API UKhopeshGameInstance : public UGameInstance
+{
+	GENERATED_BODY()
+
+public:
+	// Virtual Function
+	virtual void Init() override;
+	virtual void Shutdown() override;
+
+public:
+	// Public Function
+	bool IsCombatPreloaded() const { return IsPreloaded; }
+
+	// Calls right away once the preload is done
+	void CallWhenCombatPreloaded(FSimpleDelegate const& Callback);
+
+private:
+	// Other Function
+	void OnCombatPreloaded();
+	void OnPreLoadMap(FString const& MapName);
+	void OnPostLoadMap(UWorld* World);
+	void OnEndFrame();
+
+private:
+	// Other Variable
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+	TArray<FSimpleDelegate> PreloadCallbacks;
+	bool IsPreloaded;
+
+	double PreloadStartTime;
+	double MapLoadStartTime;
+	double MapLoadedTime;
+	FDelegateHandle EndFrameHandle;
+};
\ No newline at end of file
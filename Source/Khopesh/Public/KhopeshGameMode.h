@@ -4,38 +4,134 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "KhopeshProximityGrid.h"
+#include "KhopeshRollback.h"
+#include "KhopeshLoadRecorder.h"
+#include "KhopeshNetTypes.h"
 #include "KhopeshGameMode.generated.h"
 
+// Collected while a duel is played, and written when its result is shown.
+struct FKhopeshMatchTelemetry
+{
+	void Reset(float Time);
+
+	// Server frame work time in milliseconds, one per frame of the duel
+	TArray<float> FrameTimes;
+	float StartTime;
+	int32 Hits;
+	int32 Parries;
+};
+
+// One duel. Every PlayerStart sharing the same PlayerStartTag forms the arena of a match.
+USTRUCT()
+struct FKhopeshMatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Arena;
+
+	UPROPERTY()
+	TArray<class AKhopeshPlayerController*> Players;
+
+	UPROPERTY()
+	TArray<AActor*> Spawns;
+
+	UPROPERTY()
+	TMap<class AKhopeshPlayerController*, AActor*> TakenSpawns;
+
+	// Players of a finished match that asked for a rematch
+	UPROPERTY()
+	TArray<class AKhopeshPlayerController*> RematchPlayers;
+
+	FTimerHandle ResultTimer;
+	TSharedPtr<FKhopeshRollbackSession> DuelSession;
+	FKhopeshMatchTelemetry Telemetry;
+	double RematchRequestTime;
+	bool IsFinished;
+};
+
 UCLASS(minimalapi)
 class AKhopeshGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
+public:
+	AKhopeshGameMode();
+
 private:
+	virtual void PostInitializeComponents() override;
 	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
 	virtual void PostLogin(APlayerController* NewPlayer) override;
 	virtual void Logout(AController* Exiting) override;
+	virtual bool PlayerCanRestart_Implementation(APlayerController* Player) override;
 
 public:
 	void PlayerDead(class AKhopeshPlayerController* DeadPlayer);
+	int32 GetMatchIndex(AController const* Player) const;
+	class AKhopeshPlayerController* GetOpponent(AController const* Player) const;
+	void RecordCombatEvent(AController* Player, ECombatEvent Type);
+	void RestartWhenReady(APlayerController* Player);
+
+	// After a duel, without leaving the map
+	void RequestRematch(class AKhopeshPlayerController* Player);
+	void RequestNextMatch(class AKhopeshPlayerController* Player);
+
+	void StartDuel(AController* Player);
+	void ReceiveDuelInputs(class AKhopeshPlayerController* Player, FKhopeshDuelInputs const& Inputs);
+
+	FKhopeshProximityGrid& GetProximityGrid() { return ProximityGrid; }
+	FKhopeshLoadRecorder& GetLoadRecorder() { return LoadRecorder; }
+
+#if WITH_DEV_AUTOMATION_TESTS
+	// Test Function
+	// Pairs two controllers in an empty arena, apart from the players waiting for a match
+	bool BeginTestMatch(class AKhopeshPlayerController* First, class AKhopeshPlayerController* Second);
+	void EndTestMatch(class AKhopeshPlayerController* Player) { LeaveMatch(Player); }
+#endif
 
 protected:
 	UFUNCTION(BlueprintCallable)
 	AActor* GetPlayerStart(AController* Player);
 
 private:
+	void InitMatches();
+	void JoinMatch(class AKhopeshPlayerController* Controller);
+	void LeaveMatch(class AKhopeshPlayerController* Controller);
+	void BeginMatch(FKhopeshMatch& Match);
+	void DestroyPawn(class AKhopeshPlayerController* Player);
+	void ResetMatch(FKhopeshMatch& Match);
+	void AdvanceDuel(FKhopeshMatch& Match);
+	void StepCombat();
 	void ShowResult(class AKhopeshPlayerController* WinPlayer, class AKhopeshPlayerController* LosePlayer);
+	void WriteTelemetry(FKhopeshMatch const& Match, class AKhopeshPlayerController* WinPlayer);
+	void SetDuelOpponent(APlayerController* Player, APlayerController* Opponent);
+	void WritePoolState();
 
 private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Player, Meta = (AllowPrivateAccess = true))
 	TArray<class AKhopeshPlayerController*> Players;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Player, Meta = (AllowPrivateAccess = true))
-	TArray<AActor*> Spawns;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawn, Meta = (AllowPrivateAccess = true))
-	TMap<class AKhopeshPlayerController*, AActor*> TakenSpawns;
+	UPROPERTY(VisibleAnywhere, Category = Match)
+	TArray<FKhopeshMatch> Matches;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Result, Meta = (AllowPrivateAccess = true))
 	float ShowResultDelay;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Proximity, Meta = (AllowPrivateAccess = true))
+	float ProximityCellSize;
+
+	// Run duels with input exchange and rollback instead of server authoritative RPCs. Dedicated server only.
+	UPROPERTY(EditAnywhere, Config, BlueprintReadWrite, Category = Netcode, Meta = (AllowPrivateAccess = true))
+	bool IsRollbackMode;
+
+	TMap<class AKhopeshPlayerController*, int32> PlayerMatches;
+	FKhopeshProximityGrid ProximityGrid;
+	FKhopeshLoadRecorder LoadRecorder;
+	float CombatTime;
+
+	// State file polled by Tools/ServerPool, enabled with -KhopeshPoolState=<file>
+	FString PoolStatePath;
+	int32 FinishedMatches;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+// Server frame time, game RPC count and bandwidth, written as one CSV row per second for the load test harness.
+// Enabled with -KhopeshLoadCsv=<file>.
+class KHOPESH_API FKhopeshLoadRecorder
+{
+public:
+	// Constructor
+	FKhopeshLoadRecorder();
+
+public:
+	// Public Function
+	bool OpenFromCommandLine();
+	void Tick(UWorld* World, float DeltaSeconds, int32 NumPlayers, int32 NumDuels);
+
+	// Calls made by the server, and server RPCs it executed. Also fed to the stat and CSV profilers.
+	void CountSentRPC();
+	void CountReceivedRPC();
+
+	// Time spent on the last frame, without the sleep that caps the server tick rate
+	static double GetFrameWorkTime();
+
+private:
+	// Other Function
+	void WriteRow(UWorld* World, int32 NumPlayers, int32 NumDuels);
+
+private:
+	// Other Variable
+	TUniquePtr<FArchive> Writer;
+	float Elapsed;
+	float SampleTime;
+
+	// Current sample
+	int32 Frames;
+	double WorkTime;
+	double MaxWorkTime;
+	int32 SentRPCs;
+	int32 ReceivedRPCs;
+
+	// Net driver totals at the start of the sample
+	uint32 LastInBytes;
+	uint32 LastOutBytes;
+	uint32 LastInPackets;
+	uint32 LastOutPackets;
+};
\ No newline at end of file
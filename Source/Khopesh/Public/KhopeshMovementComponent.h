@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "KhopeshMovementComponent.generated.h"
+
+// Dodge state advanced by the movement simulation, so that it replays identically on correction.
+struct FKhopeshDodgeState
+{
+	// Seconds the dodge key has been held in combat mode. Negative while not charging.
+	float HoldTime;
+	float Cooldown;
+	bool WasHeld;
+};
+
+UCLASS()
+class KHOPESH_API UKhopeshMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshMovementComponent();
+
+	// Virtual Function
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+public:
+	// Public Function
+	void SetDodgeHeld(bool IsHeld) { IsDodgeHeld = IsHeld; }
+	bool GetDodgeHeld() const { return IsDodgeHeld; }
+
+	FKhopeshDodgeState const& GetDodgeState() const { return DodgeState; }
+	void SetDodgeState(FKhopeshDodgeState const& State) { DodgeState = State; }
+
+private:
+	// Other Function
+	void UpdateDodge(float DeltaSeconds);
+	void TryDodge(bool IsLongDodge);
+
+private:
+	// Other Variable
+	FKhopeshDodgeState DodgeState;
+	bool IsDodgeHeld;
+};
+
+class FSavedMove_Khopesh : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* Character) override;
+
+	FKhopeshDodgeState StartDodgeState;
+	bool IsDodgeHeld;
+};
+
+class FNetworkPredictionData_Client_Khopesh : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Khopesh(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/CoreNet.h"
+
+class AActor;
+
+// Payload bits of every RPC and replicated property sent on one connection, per name and per second. Bunch, property
+// handle and packet headers are not included, so reports compare changes against each other rather than the wire.
+// Enabled with -KhopeshNetReport, reports are written to Saved/NetReports at match end.
+class KHOPESH_API FKhopeshNetAccounting
+{
+public:
+	// Constructor
+	FKhopeshNetAccounting();
+
+public:
+	// Public Function
+	void Reset(float Time);
+	void Record(FName Section, FName Name, int32 Bits, float Time);
+	void AppendReport(FString& OutReport, FString const& Connection, float Time) const;
+
+	static bool IsEnabled();
+	static FString const& GetReportHeader();
+	static void SaveReport(FString const& Report, FString const& Name);
+
+	// Finds every connection the call is sent on and records it there
+	static void RecordRPC(AActor* Actor, UFunction* Function, void* Params);
+	static void RecordProperty(AActor* Actor, UProperty* Property, void const* Data, ELifetimeCondition Condition);
+
+	static int32 GetParamsBits(UFunction* Function, void* Params);
+	static int32 GetPropertyBits(UProperty* Property, void const* Data);
+
+	static FName const RPC;
+	static FName const Property;
+
+private:
+	struct FEntry
+	{
+		FEntry() : Count(0), Bits(0) {}
+
+		int32 Count;
+		int64 Bits;
+	};
+
+	// Other Function
+	static void ForEachConnection(AActor* Actor, ELifetimeCondition Condition, TFunctionRef<void(FKhopeshNetAccounting&)> Func);
+
+private:
+	// Other Variable
+	TMap<TPair<FName, FName>, FEntry> Entries;
+	TArray<FEntry> Seconds;
+	float StartTime;
+};
+
+// Last replicated value of the properties a class declares itself, compared on each net update to account what changed.
+class KHOPESH_API FKhopeshRepTracker
+{
+public:
+	// Constructor
+	FKhopeshRepTracker();
+	~FKhopeshRepTracker();
+
+public:
+	// Public Function
+	void Update(AActor* Actor, UClass* DeclaringClass);
+
+private:
+	struct FTracked
+	{
+		UProperty* Property;
+		int32 Index;
+		ELifetimeCondition Condition;
+		int32 Offset;
+	};
+
+	// Other Function
+	void Init(AActor* Actor, UClass* DeclaringClass);
+
+private:
+	// Other Variable
+	TArray<FTracked> Properties;
+	TArray<uint8, TAlignedHeapAllocator<16>> Values;
+	bool IsInitialized;
+};
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KhopeshNetReportCommandlet.generated.h"
+
+// Compares two net reports written with -KhopeshNetReport, per RPC and property in bits per second.
+// Fails when any of them grows by more than Threshold percent, so that a bandwidth regression breaks the build.
+// Usage : UE4Editor-Cmd Khopesh -run=KhopeshNetReport Base=<report.csv> New=<report.csv> [Threshold=5]
+UCLASS()
+class UKhopeshNetReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshNetReportCommandlet();
+
+	// Virtual Function
+	virtual int32 Main(FString const& Params) override;
+};
\ No newline at end of file
@@ -0,0 +1,242 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KhopeshNetTypes.generated.h"
+
+// Yaw only rotation, quantized to 16 bits on the wire. Value is not a property, so replication compares it through
+// operator==.
+USTRUCT()
+struct FKhopeshYaw
+{
+	GENERATED_BODY()
+
+	FKhopeshYaw() : Value(0) {}
+	explicit FKhopeshYaw(float Yaw) : Value(FRotator::CompressAxisToShort(Yaw)) {}
+
+	float Get() const { return FRotator::DecompressAxisFromShort(Value); }
+
+	bool operator==(FKhopeshYaw const& Other) const { return Value == Other.Value; }
+	bool operator!=(FKhopeshYaw const& Other) const { return Value != Other.Value; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		Ar << Value;
+		bOutSuccess = true;
+		return true;
+	}
+
+	uint16 Value;
+};
+
+template<>
+struct TStructOpsTypeTraits<FKhopeshYaw> : public TStructOpsTypeTraitsBase2<FKhopeshYaw>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
+
+// Last dodge started on the server, replicated to simulated proxies.
+USTRUCT()
+struct FKhopeshDodge
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 Count;
+
+	UPROPERTY()
+	bool IsLongDodge;
+
+	UPROPERTY()
+	FKhopeshYaw Yaw;
+};
+
+// HP, speed and combat mode of a character as they are sent. The server changes them through a dirty flag that bumps
+// Revision, so a net update compares one byte instead of every field.
+USTRUCT()
+struct FKhopeshStatus
+{
+	GENERATED_BODY()
+
+	// Highest HP of a character, UKhopeshCombatProfile::HP is clamped to it in the editor
+	static constexpr float MaxHP = 100.0f;
+	static constexpr uint32 MaxHPTenths = static_cast<uint32>(MaxHP * 10.0f);
+
+	FKhopeshStatus() : HP(0), Speed(0), IsCombatMode(false), Revision(0) {}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+	bool Identical(FKhopeshStatus const* Other, uint32 PortFlags) const { return Revision == Other->Revision; }
+
+	// HP in tenths, speed in cm/s
+	uint16 HP;
+	uint16 Speed;
+	bool IsCombatMode;
+
+	// Server only, never sent
+	uint8 Revision;
+};
+
+template<>
+struct TStructOpsTypeTraits<FKhopeshStatus> : public TStructOpsTypeTraitsBase2<FKhopeshStatus>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdentical = true,
+	};
+};
+
+UENUM()
+enum class ECombatEvent : uint8
+{
+	HIT,
+	DEFENSE_SUCCESS,
+	DEFENSE_FAIL,
+	BROKEN,
+};
+
+USTRUCT()
+struct FKhopeshCombatEvent
+{
+	GENERATED_BODY()
+
+	ECombatEvent Type;
+
+	// HIT : EMontage to play, DIE for the last hit. HP follows through FKhopeshStatus.
+	uint8 Montage;
+
+	// DEFENSE_SUCCESS : Rotation toward the attacker
+	FKhopeshYaw Yaw;
+};
+
+// Every combat event raised on a character during one server frame, bit-packed into a single multicast.
+USTRUCT()
+struct FKhopeshCombatEvents
+{
+	GENERATED_BODY()
+
+	static constexpr int32 MaxEvents = 7;
+
+	TArray<FKhopeshCombatEvent, TInlineAllocator<MaxEvents>> Events;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FKhopeshCombatEvents> : public TStructOpsTypeTraitsBase2<FKhopeshCombatEvents>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+// Buttons of a rollback duel input
+namespace EDuelButton
+{
+	enum Type : uint8
+	{
+		ATTACK = 1 << 0,
+		DEFENSE = 1 << 1,
+		DODGE = 1 << 2,
+	};
+}
+
+// Input of one fighter for one fixed rollback frame.
+USTRUCT()
+struct FKhopeshDuelInput
+{
+	GENERATED_BODY()
+
+	FKhopeshDuelInput() : Buttons(0), MoveForward(0), MoveRight(0) {}
+
+	bool operator==(FKhopeshDuelInput const& Other) const
+	{
+		return Buttons == Other.Buttons && MoveForward == Other.MoveForward
+			&& MoveRight == Other.MoveRight && Yaw == Other.Yaw;
+	}
+
+	bool operator!=(FKhopeshDuelInput const& Other) const { return !(*this == Other); }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	// ATTACK and DEFENSE are presses during the frame, DODGE is the held state
+	uint8 Buttons;
+	int8 MoveForward;
+	int8 MoveRight;
+
+	// Aim, used for attack, defense and movement direction
+	FKhopeshYaw Yaw;
+};
+
+template<>
+struct TStructOpsTypeTraits<FKhopeshDuelInput> : public TStructOpsTypeTraitsBase2<FKhopeshDuelInput>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+// Every input of a fighter the opponent has not acknowledged yet, resent each frame so that a lost packet is
+// covered by the next one.
+USTRUCT()
+struct FKhopeshDuelInputs
+{
+	GENERATED_BODY()
+
+	// Enough for two peers stalled at the rollback limit, see FKhopeshRollbackSession
+	static constexpr int32 MaxInputs = 24;
+
+	// Frame of the last input, the others are the frames right before it
+	int32 LastFrame;
+
+	// Last contiguous frame the sender has received from its opponent
+	int32 AckFrame;
+
+	TArray<FKhopeshDuelInput, TInlineAllocator<MaxInputs>> Inputs;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FKhopeshDuelInputs> : public TStructOpsTypeTraitsBase2<FKhopeshDuelInputs>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+// Rollback duel a character takes part in, replicated so both clients start from the same frame 0.
+USTRUCT()
+struct FKhopeshDuel
+{
+	GENERATED_BODY()
+
+	FKhopeshDuel() : Slot(0), HP(0.0f)
+	{
+		Fighters[0] = Fighters[1] = nullptr;
+	}
+
+	UPROPERTY()
+	class AKhopeshCharacter* Fighters[2];
+
+	UPROPERTY()
+	FVector_NetQuantize Locations[2];
+
+	UPROPERTY()
+	FKhopeshYaw Yaws[2];
+
+	// Index of the owning character in Fighters
+	UPROPERTY()
+	uint8 Slot;
+
+	UPROPERTY()
+	float HP;
+};
\ No newline at end of file
@@ -4,6 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "KhopeshRollback.h"
+#include "KhopeshBot.h"
+#include "KhopeshAnimBudget.h"
+#include "KhopeshEffectPool.h"
+#include "KhopeshNetAccounting.h"
 #include "KhopeshPlayerController.generated.h"
 
 UCLASS()
@@ -11,8 +16,16 @@ class KHOPESH_API AKhopeshPlayerController : public APlayerController
 {
 	GENERATED_BODY()
 
+public:
+	AKhopeshPlayerController();
+
 private:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void AcknowledgePossession(APawn* P) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual bool CallRemoteFunction(UFunction* Function, void* Parameters, struct FOutParmRec* OutParms, FFrame* Stack) override;
 	
 public:
 	UFUNCTION(Client, Reliable)
@@ -24,13 +37,86 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void BackToLobby();
 
+	// Same opponent again, or the next waiting one, without reloading the map
+	UFUNCTION(BlueprintCallable)
+	void Rematch();
+
+	UFUNCTION(BlueprintCallable)
+	void NextMatch();
+
+	UFUNCTION(Client, Reliable)
+	void StartRematch();
+
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void SendDuelInputs(FKhopeshDuelInputs const& Inputs);
+
+	UFUNCTION(Client, Unreliable)
+	void ReceiveDuelInputs(FKhopeshDuelInputs const& Inputs);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ReportCombatReady();
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void RequestRematch(bool IsSameOpponent);
+
 	void PlayerDead();
+	void StartDuel(FKhopeshDuel const& Duel);
+	FKhopeshNetAccounting& GetNetAccounting() { return NetAccounting; }
+	FKhopeshEffectPool* GetEffectPool() const { return EffectPool.Get(); }
+	APlayerState* GetOpponentState() const { return OpponentState; }
+	void SetOpponentState(APlayerState* NewOpponentState) { OpponentState = NewOpponentState; }
+	bool IsCombatReady() const { return IsReady; }
 
 private:
 	void ShowResultWidget_Implementation(bool IsWin);
 	void BlockInput_Implementation();
+	void StartRematch_Implementation();
+
+	void SendDuelInputs_Implementation(FKhopeshDuelInputs const& Inputs);
+	bool SendDuelInputs_Validate(FKhopeshDuelInputs const& Inputs);
+	void ReceiveDuelInputs_Implementation(FKhopeshDuelInputs const& Inputs);
+
+	void ReportCombatReady_Implementation();
+	bool ReportCombatReady_Validate();
+
+	void RequestRematch_Implementation(bool IsSameOpponent);
+	bool RequestRematch_Validate(bool IsSameOpponent);
 
 protected:
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnShowResultWidget(bool IsWin);
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnStartRematch();
+
+private:
+	// Rollback duel of the owning client
+	TUniquePtr<FKhopeshRollbackSession> DuelSession;
+
+	UPROPERTY()
+	FKhopeshDuel Duel;
+
+	// Player state of the duel opponent, null outside a match
+	UPROPERTY(Replicated)
+	APlayerState* OpponentState;
+
+	float DuelTime;
+
+	// Client : when the last rematch was asked for, zero when none is pending
+	double RematchRequestTime;
+
+	// Headless load test player, see FKhopeshBot
+	TUniquePtr<FKhopeshBot> Bot;
+
+	// Animation update rates of the characters this client sees
+	TUniquePtr<FKhopeshAnimBudget> AnimBudget;
+
+	// Combat effects this client plays
+	TUniquePtr<FKhopeshEffectPool> EffectPool;
+
+	// Traffic of this player's connection
+	FKhopeshNetAccounting NetAccounting;
+
+	// Server : the client has its combat montages loaded
+	bool IsReady;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KhopeshProfileMigrationCommandlet.generated.h"
+
+// Moves the tuning and montages of every character blueprint saved before the combat profiles into a new
+// UKhopeshCombatProfile next to it, named <Blueprint>_Profile, and saves both. A blueprint with a profile is skipped.
+// Must run before a cook, which drops the old properties.
+// Usage : UE4Editor-Cmd Khopesh -run=KhopeshProfileMigration
+UCLASS()
+class UKhopeshProfileMigrationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshProfileMigrationCommandlet();
+
+	// Virtual Function
+	virtual int32 Main(FString const& Params) override;
+};
\ No newline at end of file
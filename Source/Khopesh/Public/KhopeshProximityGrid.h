@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AKhopeshCharacter;
+
+// Uniform grid of characters that notifies a character when its first enemy enters or its last enemy leaves its range.
+// Only characters that moved since the last update are re-evaluated, and only characters of the same group see each other.
+class KHOPESH_API FKhopeshProximityGrid
+{
+public:
+	// Constructor
+	FKhopeshProximityGrid();
+
+public:
+	// Public Function
+	void Init(float InCellSize);
+	void Add(AKhopeshCharacter* Character, float Range, float Radius, int32 Group);
+	void Remove(AKhopeshCharacter* Character);
+	void MarkMoved(AKhopeshCharacter* Character);
+	void Update();
+
+private:
+	struct FEntry
+	{
+		AKhopeshCharacter* Character;
+		FVector Location;
+		FIntPoint Cell;
+		float Range;
+		float Radius;
+		int32 Group;
+		bool IsMoved;
+
+		// Characters inside my range, and characters whose range contains me
+		TArray<AKhopeshCharacter*, TInlineAllocator<4>> Near;
+		TArray<AKhopeshCharacter*, TInlineAllocator<4>> NearBy;
+	};
+
+private:
+	// Other Function
+	void UpdateEntry(FEntry& Entry);
+	void SetNear(FEntry& Observer, FEntry& Target, bool IsNear);
+	FIntPoint GetCell(FVector const& Location) const;
+
+private:
+	// Other Variable
+	TMap<AKhopeshCharacter*, FEntry> Entries;
+	TMap<FIntPoint, TArray<AKhopeshCharacter*>> Cells;
+	TArray<AKhopeshCharacter*> MovedCharacters;
+	float CellSize;
+	float MaxReach;
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "KhopeshReplicationGraph.generated.h"
+
+class APlayerController;
+
+enum class EClassRepNodeMapping : uint8
+{
+	// Not routed to a global node, e.g. replicated only through a connection node
+	NOT_ROUTED,
+	RELEVANT_ALL_CONNECTIONS,
+
+	// Routed to the connection node of its owner, for an actor only relevant to its owner
+	RELEVANT_OWNER_CONNECTION,
+
+	// Routed to the grid, as never moving, moving, or moving until dormant
+	SPATIALIZE_STATIC,
+	SPATIALIZE_DYNAMIC,
+	SPATIALIZE_DORMANCY,
+};
+
+// Everything a connection always gets : its controller, player state and pawn, and the same of its duel opponent,
+// whatever the distance to it.
+UCLASS()
+class UKhopeshReplicationGraphNode_Duel : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	// Virtual Function
+	virtual void NotifyAddNetworkActor(FNewReplicatedActorInfo const& ActorInfo) override {}
+	virtual bool NotifyRemoveNetworkActor(FNewReplicatedActorInfo const& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override {}
+	virtual void GatherActorListsForConnection(FConnectionGatherActorListParameters const& Params) override;
+
+public:
+	// Public Function
+	void SetOpponent(APlayerController* NewOpponent) { Opponent = NewOpponent; }
+
+private:
+	// Other Function
+	void AddPlayer(APlayerController* Player);
+
+private:
+	// Other Variable
+	FActorRepListRefView ReplicationActorList;
+	TWeakObjectPtr<APlayerController> Opponent;
+};
+
+// Replication of a server with many duels. Duel opponents are always relevant to each other, anything else is culled
+// by a spatial grid, so the cost of a connection grows with the actors around it and not with the world.
+// Actors only relevant to their owner go to a node of the owning connection. Dead characters go dormant, see
+// AKhopeshCharacter::Die.
+UCLASS(Transient, Config = Engine)
+class UKhopeshReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshReplicationGraph();
+
+	// Virtual Function
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual void RouteAddNetworkActorToNodes(FNewReplicatedActorInfo const& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(FNewReplicatedActorInfo const& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+public:
+	// Public Function
+	void SetDuelOpponent(APlayerController* Player, APlayerController* Opponent);
+
+private:
+	// Other Function
+	EClassRepNodeMapping GetMappingPolicy(UClass* Class);
+	bool AddToOwnerNode(AActor* Actor);
+
+private:
+	// Config Variable
+	UPROPERTY(Config)
+	float CellSize;
+
+	UPROPERTY(Config)
+	FVector2D SpatialBias;
+
+	// Distance past which a character of another duel is culled
+	UPROPERTY(Config)
+	float CharacterCullDistance;
+
+	// Graph Node
+	UPROPERTY()
+	class UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	class UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	UPROPERTY()
+	TMap<UNetConnection*, UKhopeshReplicationGraphNode_Duel*> DuelNodes;
+
+	UPROPERTY()
+	TMap<UNetConnection*, class UReplicationGraphNode_AlwaysRelevant_ForConnection*> OwnerNodes;
+
+	// Other Variable
+	TClassMap<EClassRepNodeMapping> ClassRepNodePolicies;
+
+	// Owner only actors added before their owner had a connection
+	TArray<TWeakObjectPtr<AActor>> PendingOwnerActors;
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FKhopeshRewindFrame
+{
+	float Time;
+	FVector Location;
+	FRotator Rotation;
+};
+
+// Fixed capacity ring buffer of server-side transforms used for lag compensation.
+class KHOPESH_API FKhopeshRewindBuffer
+{
+public:
+	// Constructor
+	FKhopeshRewindBuffer();
+
+public:
+	// Public Function
+	void Init(int32 Capacity);
+	void Reset();
+	void Record(float Time, FVector const& Location, FRotator const& Rotation);
+
+	// Interpolates the transform at Time. Clamps to the oldest or newest frame when Time is out of range.
+	bool Sample(float Time, FVector& OutLocation, FRotator& OutRotation) const;
+
+private:
+	// Other Function
+	FKhopeshRewindFrame const& GetFrame(int32 Age) const;
+
+private:
+	// Other Variable
+	TArray<FKhopeshRewindFrame> Frames;
+	int32 Head;
+	int32 Count;
+};
\ No newline at end of file
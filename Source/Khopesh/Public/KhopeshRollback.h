@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KhopeshNetTypes.h"
+#include "KhopeshCombatState.h"
+#include "KhopeshRules.h"
+
+// Timing of one combo section of an attack montage, in rollback frames.
+struct FKhopeshAttackTiming
+{
+	float StartTime;
+	uint16 HitFrame;
+	uint16 Frames;
+};
+
+// Everything the duel simulation reads but never writes. Built once per duel, so it is not part of a snapshot.
+struct KHOPESH_API FKhopeshDuelRules
+{
+	FKhopeshDuelRules();
+
+	float FrameTime;
+
+	float MoveSpeed;
+	float CapsuleRadius;
+	float AttackRange;
+	float AttackRadius;
+	float DodgeDistance[2];
+
+	FKhopeshStats Stats;
+	TArray<FKhopeshAttackTiming> AttackTimings[2];
+
+	uint16 ComboFrames;
+	uint16 DefenseFrames;
+	uint16 BrokenFrames;
+	uint16 DodgeDelayFrames;
+	uint16 DodgeReinforceFrames;
+
+	// Play length of every EMontage
+	TArray<uint16> MontageFrames;
+};
+
+// Combat state of one fighter. Plain data, so saving and restoring a frame is a copy.
+struct FKhopeshFighterState
+{
+	static constexpr uint8 NoMontage = 0xFF;
+
+	FVector Location;
+	float Yaw;
+	float HP;
+
+	uint8 Montage;
+	uint16 MontageFrame;
+
+	// Same state machine the server authoritative mode steps
+	FKhopeshCombatState Combat;
+
+	uint16 DodgeDelayFrames;
+
+	// Frames the dodge key has been held. Negative while not charging.
+	int16 DodgeHoldFrames;
+	bool WasDodgeHeld;
+};
+
+struct FKhopeshDuelSnapshot
+{
+	int32 Frame;
+	FKhopeshFighterState Fighters[2];
+};
+
+// GGPO style session of one duel. Inputs are exchanged per fixed frame, a missing remote input is predicted
+// from the last one, and a late input that differs from the prediction restores the snapshot of its frame
+// and simulates forward again. A session without a local fighter only advances on confirmed inputs, which is
+// how the server runs it.
+class KHOPESH_API FKhopeshRollbackSession
+{
+public:
+	static constexpr int32 MaxRollbackFrames = 8;
+	static constexpr int32 InputDelay = 2;
+
+	FKhopeshRollbackSession(FKhopeshDuelRules const& InRules, FKhopeshDuelSnapshot const& Start, int32 InLocalSlot);
+
+	void AddLocalInput(FKhopeshDuelInput const& Input);
+	void AddRemoteInput(int32 Slot, int32 Frame, FKhopeshDuelInput const& Input);
+	void AddRemoteInputs(int32 Slot, FKhopeshDuelInputs const& Inputs);
+	void GetLocalInputs(FKhopeshDuelInputs& OutInputs) const;
+
+	bool CanAdvance() const;
+	void Advance();
+
+	int32 GetFrame() const { return State.Frame; }
+	int32 GetLocalSlot() const { return LocalSlot; }
+	int32 GetLastRollbackFrames() const { return LastRollbackFrames; }
+	FKhopeshDuelSnapshot const& GetState() const { return State; }
+	FKhopeshDuelRules const& GetRules() const { return Rules; }
+
+	static FKhopeshDuelSnapshot MakeStart(FKhopeshDuel const& Duel);
+	static void Simulate(FKhopeshDuelRules const& Rules, FKhopeshDuelSnapshot& State, FKhopeshDuelInput const (&Inputs)[2]);
+
+private:
+	static constexpr int32 BufferSize = 32;
+
+	struct FFrameInput
+	{
+		FKhopeshDuelInput Inputs[2];
+		int32 Frame;
+		bool IsConfirmed[2];
+	};
+
+	FFrameInput& GetFrameInput(int32 Frame);
+	void SimulateFrame();
+
+	FKhopeshDuelRules Rules;
+	FKhopeshDuelSnapshot State;
+	FKhopeshDuelSnapshot Snapshots[BufferSize];
+	FFrameInput FrameInputs[BufferSize];
+
+	int32 LocalSlot;
+	int32 LastLocalFrame;
+	int32 RemoteAckFrame;
+	int32 ConfirmedFrames[2];
+	int32 RollbackFrame;
+	int32 LastRollbackFrames;
+};
\ No newline at end of file
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KhopeshRollbackCommandlet.generated.h"
+
+// Headless snapshot, restore and resimulation budget of a rollback duel.
+// Usage : UE4Editor-Cmd Khopesh -run=KhopeshRollback [Frames=36000] [Latency=6] [Seed=0]
+UCLASS()
+class UKhopeshRollbackCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	UKhopeshRollbackCommandlet();
+
+	// Virtual Function
+	virtual int32 Main(FString const& Params) override;
+};
\ No newline at end of file
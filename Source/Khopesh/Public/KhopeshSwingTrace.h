@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Position of both blades at one instant, from hilt to tip
+struct FKhopeshBladeSample
+{
+	float Time;
+	FVector Base[2];
+	FVector Tip[2];
+};
+
+struct FKhopeshBladeSegment
+{
+	float Time;
+	FVector Base;
+	FVector Tip;
+};
+
+// One swing of both blades, from the Attack notify until the swing duration is over. Blades are recorded once per
+// server frame and interpolated at a fixed sub-step rate, so that a fast swing at a low frame rate cannot pass
+// through a target between two frames. Pending segments are resolved in one batch on the next frame, and a target
+// is hit at most once per swing.
+class KHOPESH_API FKhopeshSwingTrace
+{
+public:
+	// Constructor
+	FKhopeshSwingTrace();
+
+public:
+	// Public Function
+	void Start(FKhopeshBladeSample const& Sample, float Duration, float SubstepRate, float InDamage);
+	void Record(FKhopeshBladeSample const& Sample);
+
+	bool IsActive() const { return IsRecording || Pending.Num() > 0; }
+	bool IsRecordingSwing() const { return IsRecording; }
+	float GetDamage() const { return Damage; }
+
+	TArray<FKhopeshBladeSegment> const& GetPendingSegments() const { return Pending; }
+	void ClearPending() { Pending.Reset(); }
+
+	// False if the target was already hit by this swing
+	bool TryAddHit(AActor* Target);
+
+private:
+	// Other Function
+	void AddSegments(FKhopeshBladeSample const& Sample);
+
+private:
+	// Other Variable
+	TArray<FKhopeshBladeSegment> Pending;
+	// Only compared, never dereferenced
+	TArray<AActor const*, TInlineAllocator<2>> HitActors;
+	FKhopeshBladeSample LastSample;
+	float EndTime;
+	float SubstepTime;
+	float Damage;
+	bool IsRecording;
+};
\ No newline at end of file
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshDuelSimulator.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	enum class EAction : uint8
+	{
+		IDLE,
+		ATTACK,
+		DEFENSE,
+	};
+
+	// Duels per ParallelFor task, and per random seed
+	constexpr int32 ChunkSize = 4096;
+}
+
+FKhopeshBatchResult::FKhopeshBatchResult()
+	: Duels(0), Draws(0), Exchanges(0)
+{
+	Wins[0] = Wins[1] = 0;
+	Hits[0] = Hits[1] = 0;
+	Parries[0] = Parries[1] = 0;
+}
+
+void FKhopeshBatchResult::Add(FKhopeshBatchResult const& Other)
+{
+	Duels += Other.Duels;
+	Draws += Other.Draws;
+	Exchanges += Other.Exchanges;
+
+	for (int32 Idx = 0; Idx < 2; ++Idx)
+	{
+		Wins[Idx] += Other.Wins[Idx];
+		Hits[Idx] += Other.Hits[Idx];
+		Parries[Idx] += Other.Parries[Idx];
+	}
+}
+
+FKhopeshDuelSimulator::FKhopeshDuelSimulator(FKhopeshStats const& InStats, float InHP)
+	: Stats(InStats), HP(InHP)
+{
+}
+
+void FKhopeshDuelSimulator::Simulate(FKhopeshScript const (&Scripts)[2], FRandomStream& Random, FKhopeshBatchResult& OutResult) const
+{
+	float FighterHP[2] = { HP, HP };
+	uint8 Combo[2] = { 0, 0 };
+	bool IsStrongMode[2] = { false, false };
+
+	++OutResult.Duels;
+
+	for (int32 Exchange = 0; Exchange < MaxExchanges; ++Exchange)
+	{
+		++OutResult.Exchanges;
+
+		EAction Actions[2];
+		for (int32 Idx = 0; Idx < 2; ++Idx)
+		{
+			float const Roll = Random.GetFraction();
+			Actions[Idx] = (Roll < Scripts[Idx].AttackChance) ? EAction::ATTACK
+				: (Roll < Scripts[Idx].AttackChance + Scripts[Idx].DefenseChance) ? EAction::DEFENSE : EAction::IDLE;
+		}
+
+		// Who acts first is a coin flip, so neither side gets the initiative for free
+		int32 const First = Random.RandHelper(2);
+
+		for (int32 Order = 0; Order < 2; ++Order)
+		{
+			int32 const Attacker = (First + Order) % 2;
+			int32 const Defender = 1 - Attacker;
+
+			if (Actions[Attacker] != EAction::ATTACK)
+			{
+				Combo[Attacker] = 0;
+				continue;
+			}
+
+			if (FighterHP[Attacker] <= 0.0f) continue;
+
+			bool const IsStrongAttack = IsStrongMode[Attacker];
+			IsStrongMode[Attacker] = false;
+			Combo[Attacker] = FKhopeshRules::GetNextCombo(Combo[Attacker], Stats.MaxCombo);
+
+			// The attacker faces along yaw 0, the defender turns back toward it
+			float const DefenderYaw = FRotator::NormalizeAxis(180.0f + Random.FRandRange(-Scripts[Defender].FacingError, Scripts[Defender].FacingError));
+			if (Actions[Defender] == EAction::DEFENSE && FKhopeshRules::IsParried(DefenderYaw, 0.0f))
+			{
+				++OutResult.Parries[Defender];
+				IsStrongMode[Defender] = true;
+				Combo[Attacker] = 0;
+				continue;
+			}
+
+			TArray<uint8> const& HitNum = IsStrongAttack ? Stats.StrongAttackHitNum : Stats.WeakAttackHitNum;
+			int32 const Hits = HitNum[FKhopeshRules::GetComboIndex(Combo[Attacker], HitNum.Num())];
+			float const Damage = Stats.GetHitDamage(IsStrongAttack, Combo[Attacker]);
+
+			FighterHP[Defender] = FMath::Max(FighterHP[Defender] - Damage * Hits, 0.0f);
+			OutResult.Hits[Attacker] += Hits;
+		}
+
+		bool const IsDead[2] = { FighterHP[0] <= 0.0f, FighterHP[1] <= 0.0f };
+		if (IsDead[0] || IsDead[1])
+		{
+			if (IsDead[0] && IsDead[1])
+			{
+				++OutResult.Draws;
+			}
+			else
+			{
+				++OutResult.Wins[IsDead[0] ? 1 : 0];
+			}
+
+			return;
+		}
+	}
+
+	++OutResult.Draws;
+}
+
+FKhopeshBatchResult FKhopeshDuelSimulator::SimulateBatch(FKhopeshScript const (&Scripts)[2], int32 NumDuels, int32 Seed) const
+{
+	int32 const NumChunks = FMath::DivideAndRoundUp(NumDuels, ChunkSize);
+	TArray<FKhopeshBatchResult> ChunkResults;
+	ChunkResults.SetNum(NumChunks);
+
+	ParallelFor(NumChunks, [&](int32 Chunk)
+	{
+		FRandomStream Random(Seed + Chunk);
+		int32 const Count = FMath::Min(ChunkSize, NumDuels - Chunk * ChunkSize);
+
+		for (int32 Idx = 0; Idx < Count; ++Idx)
+		{
+			Simulate(Scripts, Random, ChunkResults[Chunk]);
+		}
+	});
+
+	FKhopeshBatchResult Result;
+	for (FKhopeshBatchResult const& ChunkResult : ChunkResults)
+	{
+		Result.Add(ChunkResult);
+	}
+
+	return Result;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshRules.h"
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, KhopeshRules);
+
+FKhopeshStats::FKhopeshStats()
+{
+	// Defaults for simulation without a character
+	WeakAttackDamage = 10.0f;
+	StrongAttackDamage = 20.0f;
+	MaxCombo = 3;
+	WeakAttackHitNum.Init(1, MaxCombo);
+	StrongAttackHitNum.Init(1, MaxCombo);
+}
+
+float FKhopeshStats::GetHitDamage(bool IsStrongAttack, uint8 Combo) const
+{
+	return IsStrongAttack
+		? FKhopeshRules::GetHitDamage(StrongAttackDamage, StrongAttackHitNum, Combo)
+		: FKhopeshRules::GetHitDamage(WeakAttackDamage, WeakAttackHitNum, Combo);
+}
+
+bool FKhopeshStats::Validate(FString& OutError) const
+{
+	if (MaxCombo == 0)
+	{
+		OutError = TEXT("MaxCombo is 0");
+		return false;
+	}
+
+	auto ValidateHitNum = [this, &OutError](TArray<uint8> const& HitNum, TCHAR const* Name)
+	{
+		if (HitNum.Num() < MaxCombo)
+		{
+			OutError = FString::Printf(TEXT("%s has %d entries for %d combo sections"), Name, HitNum.Num(), MaxCombo);
+			return false;
+		}
+
+		if (HitNum.Contains(0))
+		{
+			OutError = FString::Printf(TEXT("%s has a section without hit"), Name);
+			return false;
+		}
+
+		return true;
+	};
+
+	return ValidateHitNum(WeakAttackHitNum, TEXT("WeakAttackHitNum")) && ValidateHitNum(StrongAttackHitNum, TEXT("StrongAttackHitNum"));
+}
+
+uint8 FKhopeshRules::GetNextCombo(uint8 Combo, uint8 MaxCombo)
+{
+	return Combo % MaxCombo + 1;
+}
+
+int32 FKhopeshRules::GetComboIndex(uint8 Combo, int32 HitNumCount)
+{
+	return (Combo > 0) ? Combo - 1 : HitNumCount - 1;
+}
+
+float FKhopeshRules::GetHitDamage(float AttackDamage, TArray<uint8> const& HitNum, uint8 Combo)
+{
+	return AttackDamage / HitNum[GetComboIndex(Combo, HitNum.Num())];
+}
+
+bool FKhopeshRules::IsParried(float DefenderYaw, float AttackerYaw)
+{
+	// 170 and -170 are 20 degrees apart, not 340
+	return FMath::Abs(FMath::FindDeltaAngleDegrees(AttackerYaw, DefenderYaw)) >= ParryAngle;
+}
+
+EHitDirection FKhopeshRules::GetHitDirection(float DefenderYaw, float AttackerYaw)
+{
+	float Dir = DefenderYaw - AttackerYaw;
+	Dir = (FMath::Abs(Dir) > 180.0f) ? (Dir - (360.0f * FMath::Sign(Dir))) : Dir;
+
+	// Facing the same way as the attacker means being hit in the back
+	if (FMath::Abs(Dir) <= 45.0f) return EHitDirection::BACK;
+	if (FMath::Abs(Dir) >= 135.0f) return EHitDirection::FRONT;
+	return (Dir > 0.0f) ? EHitDirection::LEFT : EHitDirection::RIGHT;
+}
\ No newline at end of file
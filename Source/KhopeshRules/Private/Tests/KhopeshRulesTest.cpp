@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KhopeshRules.h"
+#include "KhopeshDuelSimulator.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKhopeshIsParriedTest, "Khopesh.Rules.IsParried",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FKhopeshIsParriedTest::RunTest(FString const& Parameters)
+{
+	TestTrue(TEXT("Face to face parries"), FKhopeshRules::IsParried(180.0f, 0.0f));
+	TestTrue(TEXT("-180 is face to face too"), FKhopeshRules::IsParried(-180.0f, 0.0f));
+	TestTrue(TEXT("The parry angle parries"), FKhopeshRules::IsParried(FKhopeshRules::ParryAngle, 0.0f));
+	TestFalse(TEXT("Under the parry angle does not parry"), FKhopeshRules::IsParried(100.0f, 0.0f));
+	TestFalse(TEXT("The same facing does not parry"), FKhopeshRules::IsParried(0.0f, 0.0f));
+
+	// The raw differences are 340 and 250
+	TestFalse(TEXT("170 against -170 is 20 degrees apart"), FKhopeshRules::IsParried(170.0f, -170.0f));
+	TestFalse(TEXT("-125 against 125 is 110 degrees apart"), FKhopeshRules::IsParried(-125.0f, 125.0f));
+	TestTrue(TEXT("-10 against 170 is face to face"), FKhopeshRules::IsParried(-10.0f, 170.0f));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKhopeshHitDirectionTest, "Khopesh.Rules.HitDirection",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FKhopeshHitDirectionTest::RunTest(FString const& Parameters)
+{
+	auto TestDirection = [this](TCHAR const* What, float DefenderYaw, float AttackerYaw, EHitDirection Expected)
+	{
+		TestEqual(What, static_cast<int32>(FKhopeshRules::GetHitDirection(DefenderYaw, AttackerYaw)), static_cast<int32>(Expected));
+	};
+
+	TestDirection(TEXT("Face to face is the front"), 180.0f, 0.0f, EHitDirection::FRONT);
+	TestDirection(TEXT("The same facing is the back"), 0.0f, 0.0f, EHitDirection::BACK);
+	TestDirection(TEXT("Turned left of the attacker is the left"), 90.0f, 0.0f, EHitDirection::LEFT);
+	TestDirection(TEXT("Turned right of the attacker is the right"), -90.0f, 0.0f, EHitDirection::RIGHT);
+
+	// Across the -180 / 180 seam
+	TestDirection(TEXT("170 against -170 is the back"), 170.0f, -170.0f, EHitDirection::BACK);
+	TestDirection(TEXT("-170 against 100 is the left"), -170.0f, 100.0f, EHitDirection::LEFT);
+	TestDirection(TEXT("-10 against 170 is the front"), -10.0f, 170.0f, EHitDirection::FRONT);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKhopeshDuelSimulatorTest, "Khopesh.Rules.DuelSimulator",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FKhopeshDuelSimulatorTest::RunTest(FString const& Parameters)
+{
+	int32 const Duels = 1000;
+	FKhopeshDuelSimulator const Simulator(FKhopeshStats(), 100.0f);
+
+	// Fighter 0 only attacks, fighter 1 only defends
+	FKhopeshScript Scripts[2];
+	Scripts[0].AttackChance = 1.0f;
+	Scripts[0].DefenseChance = 0.0f;
+	Scripts[1].AttackChance = 0.0f;
+	Scripts[1].DefenseChance = 1.0f;
+
+	FKhopeshBatchResult const Result = Simulator.SimulateBatch(Scripts, Duels, 0);
+	FKhopeshBatchResult const Again = Simulator.SimulateBatch(Scripts, Duels, 0);
+	TestEqual(TEXT("The same seed plays the same duels"), Again.Exchanges, Result.Exchanges);
+	TestEqual(TEXT("The same seed gives the same hits"), Again.Hits[0], Result.Hits[0]);
+
+	TestEqual(TEXT("Every duel is played"), Result.Duels, static_cast<int64>(Duels));
+	TestTrue(TEXT("The default facing error parries some attacks"), Result.Parries[1] > 0);
+	TestTrue(TEXT("The default facing error lets some attacks hit"), Result.Hits[0] > 0);
+
+	// Turned straight to the attacker, every defense parries
+	Scripts[1].FacingError = 0.0f;
+	FKhopeshBatchResult const Facing = Simulator.SimulateBatch(Scripts, Duels, 0);
+	TestEqual(TEXT("A perfect defense is never hit"), Facing.Hits[0], static_cast<int64>(0));
+	TestEqual(TEXT("A perfect defense only draws"), Facing.Draws, static_cast<int64>(Duels));
+
+	// Without a defense, the attacker wins every duel
+	Scripts[1].DefenseChance = 0.0f;
+	FKhopeshBatchResult const Idle = Simulator.SimulateBatch(Scripts, Duels, 0);
+	TestEqual(TEXT("An idle fighter always loses"), Idle.Wins[0], static_cast<int64>(Duels));
+	TestEqual(TEXT("An idle fighter never parries"), Idle.Parries[1], static_cast<int64>(0));
+
+	return true;
+}
+
+#endif
\ No newline at end of file
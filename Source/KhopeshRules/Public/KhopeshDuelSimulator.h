@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KhopeshRules.h"
+
+// Scripted behaviour of a fighter, as chances per exchange.
+struct FKhopeshScript
+{
+	FKhopeshScript() : AttackChance(0.5f), DefenseChance(0.3f), FacingError(90.0f) {}
+
+	float AttackChance;
+	float DefenseChance;
+
+	// Maximum yaw error when turning to the opponent, decides how often a defense parries.
+	// A defense parries while the error stays within 180 - ParryAngle, so the default parries 3 times out of 4.
+	float FacingError;
+};
+
+struct KHOPESHRULES_API FKhopeshBatchResult
+{
+	FKhopeshBatchResult();
+
+	void Add(FKhopeshBatchResult const& Other);
+
+	int64 Duels;
+	int64 Draws;
+	int64 Exchanges;
+	int64 Wins[2];
+	int64 Hits[2];
+	int64 Parries[2];
+};
+
+// Plays scripted duels with the combat rules only. An exchange is one action of each fighter: attacks resolve
+// against the defense of the other with the parry test, then hit by hit with the combo damage split.
+class KHOPESHRULES_API FKhopeshDuelSimulator
+{
+public:
+	static constexpr int32 MaxExchanges = 1000;
+
+	FKhopeshDuelSimulator(FKhopeshStats const& InStats, float InHP);
+
+	void Simulate(FKhopeshScript const (&Scripts)[2], FRandomStream& Random, FKhopeshBatchResult& OutResult) const;
+
+	// Spread over every core. The same seed gives the same result whatever the core count.
+	FKhopeshBatchResult SimulateBatch(FKhopeshScript const (&Scripts)[2], int32 NumDuels, int32 Seed) const;
+
+private:
+	FKhopeshStats Stats;
+	float HP;
+};
\ No newline at end of file
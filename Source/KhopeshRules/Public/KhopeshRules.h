@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Side of the defender that was hit. Same order as EMontage::HIT_FRONT ~ HIT_RIGHT.
+enum class EHitDirection : uint8
+{
+	FRONT,
+	LEFT,
+	BACK,
+	RIGHT,
+};
+
+// Balance numbers of a fighter, the Stat properties of AKhopeshCharacter.
+struct KHOPESHRULES_API FKhopeshStats
+{
+	FKhopeshStats();
+
+	float GetHitDamage(bool IsStrongAttack, uint8 Combo) const;
+
+	// Every combo section needs a hit count, false with the reason otherwise
+	bool Validate(FString& OutError) const;
+
+	float WeakAttackDamage;
+	float StrongAttackDamage;
+	TArray<uint8> WeakAttackHitNum;
+	TArray<uint8> StrongAttackHitNum;
+	uint8 MaxCombo;
+};
+
+struct KHOPESHRULES_API FKhopeshRules
+{
+	// Minimum angle between the defender's and the attacker's yaws for a parry
+	static constexpr float ParryAngle = 112.5f;
+
+	// Combo section played after Combo, from 1 to MaxCombo
+	static uint8 GetNextCombo(uint8 Combo, uint8 MaxCombo);
+
+	// Index of the played combo section in a HitNum array. A reset combo counts as the last section.
+	static int32 GetComboIndex(uint8 Combo, int32 HitNumCount);
+
+	// An attack hits HitNum times per section, so each hit deals a share of the attack damage
+	static float GetHitDamage(float AttackDamage, TArray<uint8> const& HitNum, uint8 Combo);
+
+	static bool IsParried(float DefenderYaw, float AttackerYaw);
+	static EHitDirection GetHitDirection(float DefenderYaw, float AttackerYaw);
+};
\ No newline at end of file
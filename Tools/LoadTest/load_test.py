@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Launches a local KhopeshServer and N pairs of headless bot clients, and records the server load as CSV.
+
+Every process runs on this machine over the loopback interface, so no network or online service is needed.
+
+Example:
+    python3 load_test.py --server Binaries/Linux/KhopeshServer --client Binaries/Linux/KhopeshClient \\
+        --map /Game/Map/Stage --pairs 1,2,4,8,16 --duration 60
+"""
+
+import argparse
+import csv
+import os
+import signal
+import subprocess
+import sys
+import time
+
+# The first seconds are connection and spawn, not steady state
+WARMUP_SECONDS = 10
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--server", required=True, help="KhopeshServer executable")
+    parser.add_argument("--client", required=True, help="KhopeshClient executable")
+    parser.add_argument("--map", required=True, help="Map with one arena per duel")
+    parser.add_argument("--pairs", default="1", help="Comma separated bot pair counts, one run each")
+    parser.add_argument("--duration", type=int, default=60, help="Seconds per run")
+    parser.add_argument("--port", type=int, default=7777)
+    parser.add_argument("--strategy", default="Random", choices=["Random", "Aggressive", "Defensive"])
+    parser.add_argument("--rollback", action="store_true", help="Run duels in rollback mode")
+    parser.add_argument("--out", default="LoadTest", help="Output directory")
+    return parser.parse_args()
+
+
+def launch_server(args, run_dir):
+    command = [
+        args.server, args.map,
+        "-port={}".format(args.port),
+        "-KhopeshLoadCsv={}".format(os.path.abspath(os.path.join(run_dir, "server.csv"))),
+        "-log=server.log", "-unattended", "-nosound",
+    ]
+    if args.rollback:
+        command.append("-ini:Game:[/Script/Khopesh.KhopeshGameMode]:IsRollbackMode=True")
+
+    return subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def launch_bot(args, run_dir, index):
+    command = [
+        args.client, "127.0.0.1:{}".format(args.port),
+        "-KhopeshBot={}".format(args.strategy),
+        "-BotSeed={}".format(index),
+        "-log=bot_{}.log".format(index),
+        "-nullrhi", "-nosound", "-unattended", "-windowed", "-ResX=320", "-ResY=240",
+        # A headless client would otherwise spin as fast as it can and starve the server
+        "-ExecCmds=t.MaxFPS 60",
+    ]
+    log = open(os.path.join(run_dir, "bot_{}.out".format(index)), "w")
+    return subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT)
+
+
+def stop(processes):
+    for process in processes:
+        if process.poll() is None:
+            process.send_signal(signal.SIGINT)
+
+    deadline = time.time() + 10
+    for process in processes:
+        try:
+            process.wait(max(deadline - time.time(), 0))
+        except subprocess.TimeoutExpired:
+            process.kill()
+
+
+def percentile(values, ratio):
+    values = sorted(values)
+    return values[min(int(len(values) * ratio), len(values) - 1)]
+
+
+def summarize(pairs, server_csv):
+    with open(server_csv) as file:
+        rows = [row for row in csv.DictReader(file) if float(row["time"]) >= WARMUP_SECONDS]
+
+    if not rows:
+        return None
+
+    def column(name):
+        return [float(row[name]) for row in rows]
+
+    return {
+        "pairs": pairs,
+        "players": int(max(column("players"))),
+        "duels": int(max(column("duels"))),
+        "frame_ms_avg": sum(column("frame_ms_avg")) / len(rows),
+        "frame_ms_p99": percentile(column("frame_ms_max"), 0.99),
+        "rpc_sent_per_sec": sum(column("rpc_sent")) / len(rows),
+        "rpc_received_per_sec": sum(column("rpc_received")) / len(rows),
+        "kbps_in": sum(column("bytes_in")) * 8 / 1000 / len(rows),
+        "kbps_out": sum(column("bytes_out")) * 8 / 1000 / len(rows),
+    }
+
+
+def run(args, pairs):
+    run_dir = os.path.join(args.out, "pairs_{}".format(pairs))
+    os.makedirs(run_dir, exist_ok=True)
+
+    server = launch_server(args, run_dir)
+    time.sleep(5)
+
+    bots = []
+    try:
+        for index in range(pairs * 2):
+            bots.append(launch_bot(args, run_dir, index))
+            # Staggered, so that both bots of a pair join the same arena
+            time.sleep(0.5)
+
+        time.sleep(args.duration)
+    finally:
+        stop(bots)
+        stop([server])
+
+    server_csv = os.path.join(run_dir, "server.csv")
+    if not os.path.exists(server_csv):
+        print("pairs={}: the server wrote no samples, see its log".format(pairs), file=sys.stderr)
+        return None
+
+    return summarize(pairs, server_csv)
+
+
+def main():
+    args = parse_args()
+    os.makedirs(args.out, exist_ok=True)
+
+    summary_path = os.path.join(args.out, "summary.csv")
+    with open(summary_path, "w", newline="") as file:
+        writer = None
+
+        for pairs in [int(value) for value in args.pairs.split(",")]:
+            result = run(args, pairs)
+            if result is None:
+                continue
+
+            if writer is None:
+                writer = csv.DictWriter(file, fieldnames=list(result.keys()))
+                writer.writeheader()
+
+            writer.writerow(result)
+            file.flush()
+            print("pairs={pairs} duels={duels} frame avg {frame_ms_avg:.2f} ms p99 {frame_ms_p99:.2f} ms, "
+                  "{kbps_out:.0f} kbps out".format(**result))
+
+    print("Summary written to {}".format(summary_path))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""Keeps a pool of booted, map-loaded KhopeshServer processes and hands a ready one to the next pair of players.
+
+Every server runs on this machine, pinned to its own core, and reports its state through -KhopeshPoolState.
+A matchmaker asks for a server over a small local HTTP API:
+
+    POST /allocate   -> 200 {"id": 3, "address": "127.0.0.1:7780"}, or 503 when none is ready
+    GET  /servers    -> 200 [{"id": 0, "port": 7777, "core": 2, "state": "ready", ...}, ...]
+
+A server is recycled once its match has shown its result and the players left. It goes back to the pool as is,
+or is restarted after --max-matches matches so that a long lived process never drifts.
+
+Example:
+    python3 server_pool.py --server Binaries/Linux/KhopeshServer --map /Game/Map/Stage --size 4 --cores 2-5
+"""
+
+import argparse
+import json
+import os
+import signal
+import subprocess
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+# How often the pool reads the state files
+POLL_SECONDS = 0.25
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--server", required=True, help="KhopeshServer executable")
+    parser.add_argument("--map", required=True, help="Map every server loads")
+    parser.add_argument("--size", type=int, default=4, help="Server processes kept booted")
+    parser.add_argument("--cores", default=None, help="Cores to pin the servers to, like 2-5 or 2,4,6. All by default")
+    parser.add_argument("--port", type=int, default=7777, help="Game port of the first server")
+    parser.add_argument("--api-port", type=int, default=8777, help="Port of the local HTTP API")
+    parser.add_argument("--max-matches", type=int, default=20, help="Matches a server hosts before it is restarted")
+    parser.add_argument("--claim-timeout", type=float, default=30.0, help="Seconds allocated players have to connect")
+    parser.add_argument("--result-timeout", type=float, default=60.0,
+                        help="Seconds players may stay on the result screen before the server is restarted")
+    parser.add_argument("--out", default="ServerPool", help="Directory for state files and logs")
+    return parser.parse_args()
+
+
+def parse_cores(value):
+    if not value:
+        return sorted(os.sched_getaffinity(0))
+
+    cores = []
+    for part in value.split(","):
+        if "-" in part:
+            first, last = part.split("-")
+            cores.extend(range(int(first), int(last) + 1))
+        else:
+            cores.append(int(part))
+    return cores
+
+
+class Server:
+    def __init__(self, index, port, core, out):
+        self.index = index
+        self.port = port
+        self.core = core
+        self.state_path = os.path.abspath(os.path.join(out, "server_{}.json".format(index)))
+        self.log_name = "pool_server_{}.log".format(index)
+        self.process = None
+        self.state = "stopped"
+        self.players = 0
+        self.matches = 0
+        self.start_time = 0.0
+        self.boot_seconds = None
+
+        # Set while handed to a pair of players
+        self.allocated_time = None
+        self.allocated_matches = 0
+        self.finished_time = None
+
+    def start(self, args):
+        if os.path.exists(self.state_path):
+            os.remove(self.state_path)
+
+        command = [
+            args.server, args.map,
+            "-port={}".format(self.port),
+            "-KhopeshPoolState={}".format(self.state_path),
+            "-log={}".format(self.log_name), "-unattended", "-nosound",
+        ]
+
+        core = self.core
+        self.process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                                        preexec_fn=lambda: os.sched_setaffinity(0, {core}))
+        self.state = "loading"
+        self.players = 0
+        self.matches = 0
+        self.start_time = time.time()
+        self.boot_seconds = None
+        self.allocated_time = None
+        self.finished_time = None
+
+    def stop(self):
+        if self.process and self.process.poll() is None:
+            self.process.send_signal(signal.SIGINT)
+            try:
+                self.process.wait(10)
+            except subprocess.TimeoutExpired:
+                self.process.kill()
+
+        self.process = None
+        self.state = "stopped"
+
+    def read_state(self):
+        try:
+            with open(self.state_path) as file:
+                report = json.load(file)
+        except (OSError, ValueError):
+            return
+
+        self.state = report["state"]
+        self.players = report["players"]
+        self.matches = report["matches"]
+
+        if self.state != "loading" and self.boot_seconds is None:
+            self.boot_seconds = time.time() - self.start_time
+
+    def is_free(self):
+        return self.state == "ready" and self.allocated_time is None
+
+    def describe(self):
+        return {
+            "id": self.index,
+            "port": self.port,
+            "core": self.core,
+            "state": self.state,
+            "allocated": self.allocated_time is not None,
+            "players": self.players,
+            "matches": self.matches,
+            "boot_seconds": self.boot_seconds,
+        }
+
+
+class Pool:
+    def __init__(self, args):
+        self.args = args
+        self.lock = threading.Lock()
+
+        cores = parse_cores(args.cores)
+        self.servers = [Server(index, args.port + index, cores[index % len(cores)], args.out)
+                        for index in range(args.size)]
+
+    def start(self):
+        for server in self.servers:
+            server.start(self.args)
+
+    def stop(self):
+        with self.lock:
+            for server in self.servers:
+                server.stop()
+
+    def allocate(self):
+        with self.lock:
+            server = next((server for server in self.servers if server.is_free()), None)
+            if server is None:
+                return None
+
+            server.allocated_time = time.time()
+            server.allocated_matches = server.matches
+            return server.describe()
+
+    def describe(self):
+        with self.lock:
+            return [server.describe() for server in self.servers]
+
+    def update(self):
+        with self.lock:
+            now = time.time()
+            for server in self.servers:
+                self.update_server(server, now)
+
+    def update_server(self, server, now):
+        if server.process is None or server.process.poll() is not None:
+            print("server {} exited, restarting".format(server.index), file=sys.stderr)
+            server.start(self.args)
+            return
+
+        server.read_state()
+        if server.allocated_time is None:
+            return
+
+        # The count tells a played match, a short "finished" state may fall between two polls
+        if server.matches > server.allocated_matches:
+            if server.state == "ready":
+                # Result shown and the players left, the match map is reset in place
+                self.recycle(server)
+            elif server.state == "finished":
+                if server.finished_time is None:
+                    server.finished_time = now
+                elif now - server.finished_time > self.args.result_timeout:
+                    self.restart(server)
+            else:
+                # A rematch started in place, the result timeout starts over when it ends
+                server.finished_time = None
+        elif server.state == "ready" and server.players == 0 and now - server.allocated_time > self.args.claim_timeout:
+            # Nobody came
+            server.allocated_time = None
+
+    def recycle(self, server):
+        if server.matches >= self.args.max_matches:
+            self.restart(server)
+            return
+
+        server.allocated_time = None
+        server.finished_time = None
+
+    def restart(self, server):
+        server.stop()
+        server.start(self.args)
+
+
+def make_handler(pool):
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path == "/servers":
+                self.reply(200, pool.describe())
+            else:
+                self.reply(404, {"error": "unknown path"})
+
+        def do_POST(self):
+            if self.path != "/allocate":
+                self.reply(404, {"error": "unknown path"})
+                return
+
+            server = pool.allocate()
+            if server is None:
+                self.reply(503, {"error": "no ready server"})
+            else:
+                self.reply(200, {"id": server["id"], "address": "127.0.0.1:{}".format(server["port"])})
+
+        def reply(self, status, body):
+            data = json.dumps(body).encode()
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+        def log_message(self, format, *args):
+            pass
+
+    return Handler
+
+
+def main():
+    args = parse_args()
+    os.makedirs(args.out, exist_ok=True)
+
+    pool = Pool(args)
+    pool.start()
+
+    # Loopback only, the matchmaker runs on the same box
+    api = ThreadingHTTPServer(("127.0.0.1", args.api_port), make_handler(pool))
+    threading.Thread(target=api.serve_forever, daemon=True).start()
+    print("Pool of {} servers, API on 127.0.0.1:{}".format(args.size, args.api_port))
+
+    try:
+        while True:
+            pool.update()
+            time.sleep(POLL_SECONDS)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        api.shutdown()
+        pool.stop()
+
+
+if __name__ == "__main__":
+    main()